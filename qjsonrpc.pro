@@ -28,7 +28,15 @@ DEFINES += QT_DEPRECATED_WARNINGS
 
 PRECOMPILED_HEADER = $${NAME_APPLICATION}/stable.h
 
-CONFIG += c++17 shared warn_on
+CONFIG += c++17 warn_on
+
+# qmake CONFIG+=qjsonrpc_static - static library, CONFIG+=ltcg - link time optimization
+qjsonrpc_static {
+    CONFIG += staticlib
+    DEFINES += QJSONRPC_STATIC
+} else {
+    CONFIG += shared
+}
 
 build_pass {
     CONFIG(debug, debug|release) {
@@ -47,10 +55,57 @@ DESTDIR = $${BUILD_PREFIX}/bin
 
 HEADERS += \
     $${NAME_APPLICATION}/qjsonrpc-export.hpp \
-    $${NAME_APPLICATION}/qjson-rpc.hpp
+    $${NAME_APPLICATION}/qjson-rpc.hpp \
+    $${NAME_APPLICATION}/qjson-rpc-inline.hpp \
+    $${NAME_APPLICATION}/qjson-rpc-scanner.hpp \
+    $${NAME_APPLICATION}/qjson-rpc-peek.hpp \
+    $${NAME_APPLICATION}/qjson-rpc-batcher.hpp \
+    $${NAME_APPLICATION}/qjson-rpc-writer.hpp \
+    $${NAME_APPLICATION}/qjson-rpc-dispatcher.hpp \
+    $${NAME_APPLICATION}/qjson-rpc-cache.hpp \
+    $${NAME_APPLICATION}/qjson-rpc-inflight.hpp \
+    $${NAME_APPLICATION}/qjson-rpc-admission.hpp \
+    $${NAME_APPLICATION}/qjson-rpc-cancel.hpp \
+    $${NAME_APPLICATION}/qjson-rpc-stream.hpp \
+    $${NAME_APPLICATION}/qjson-rpc-broadcast.hpp \
+    $${NAME_APPLICATION}/qjson-rpc-frame.hpp \
+    $${NAME_APPLICATION}/qjson-rpc-pool.hpp \
+    $${NAME_APPLICATION}/qjson-rpc-parallel.hpp \
+    $${NAME_APPLICATION}/qjson-rpc-promise.hpp
 
 SOURCES += \
-    $${NAME_APPLICATION}/qjson-rpc.cpp
+    $${NAME_APPLICATION}/qjson-rpc.cpp \
+    $${NAME_APPLICATION}/qjson-rpc-scanner.cpp \
+    $${NAME_APPLICATION}/qjson-rpc-peek.cpp \
+    $${NAME_APPLICATION}/qjson-rpc-batcher.cpp \
+    $${NAME_APPLICATION}/qjson-rpc-writer.cpp \
+    $${NAME_APPLICATION}/qjson-rpc-dispatcher.cpp \
+    $${NAME_APPLICATION}/qjson-rpc-cache.cpp \
+    $${NAME_APPLICATION}/qjson-rpc-inflight.cpp \
+    $${NAME_APPLICATION}/qjson-rpc-admission.cpp \
+    $${NAME_APPLICATION}/qjson-rpc-cancel.cpp \
+    $${NAME_APPLICATION}/qjson-rpc-stream.cpp \
+    $${NAME_APPLICATION}/qjson-rpc-broadcast.cpp \
+    $${NAME_APPLICATION}/qjson-rpc-frame.cpp \
+    $${NAME_APPLICATION}/qjson-rpc-pool.cpp \
+    $${NAME_APPLICATION}/qjson-rpc-parallel.cpp \
+    $${NAME_APPLICATION}/qjson-rpc-promise.cpp
+
+# qmake CONFIG+=qjsonrpc_io_uring - io_uring server backend, needs liburing 2.4+
+linux {
+    HEADERS += \
+        $${NAME_APPLICATION}/qjson-rpc-shm.hpp \
+        $${NAME_APPLICATION}/qjson-rpc-uring.hpp
+    SOURCES += \
+        $${NAME_APPLICATION}/qjson-rpc-shm.cpp \
+        $${NAME_APPLICATION}/qjson-rpc-uring.cpp
+
+    qjsonrpc_io_uring {
+        DEFINES += QJSONRPC_WITH_IO_URING
+        CONFIG += link_pkgconfig
+        PKGCONFIG += liburing
+    }
+}
 
 OTHER_FILES += \
     scripts/general.sh \
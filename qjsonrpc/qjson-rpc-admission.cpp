@@ -0,0 +1,173 @@
+#include <qjsonrpc/qjson-rpc-admission.hpp>
+
+#include <QList>
+#include <QMutexLocker>
+
+#include <cmath>
+
+
+namespace rpc {
+namespace qjson {
+
+inline namespace _2_0 {
+
+namespace {
+
+// defaults recommended by CoDel paper
+constexpr std::chrono::microseconds const codel_target{ 5'000 };
+constexpr std::chrono::microseconds const codel_interval{ 100'000 };
+
+[[nodiscard]] qint64 nsecs(std::chrono::microseconds us)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(us).count();
+}
+
+} // namespace
+
+
+AdmissionController::AdmissionController(int priorities, int queue_limit)
+    : m_queues(qMax(priorities, 1)), m_target(nsecs(codel_target)), m_interval(nsecs(codel_interval))
+{
+    for (Queue &queue : m_queues)
+        queue.limit = queue_limit;
+    m_clock.start();
+}
+
+int AdmissionController::priorities() const
+{
+    return m_queues.size();
+}
+
+void AdmissionController::setPriority(QString method, int priority)
+{
+    Q_ASSERT(0 <= priority && priority < m_queues.size());
+    QMutexLocker locker(&m_mutex);
+    m_priorities.insert(qMove(method), qBound(0, priority, m_queues.size() - 1));
+}
+
+int AdmissionController::priority(QString const &method) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_priorities.value(method, m_queues.size() - 1);
+}
+
+void AdmissionController::setQueueLimit(int priority, int limit)
+{
+    Q_ASSERT(0 <= priority && priority < m_queues.size());
+    QMutexLocker locker(&m_mutex);
+    m_queues[ priority ].limit = limit;
+}
+
+int AdmissionController::queueLimit(int priority) const
+{
+    Q_ASSERT(0 <= priority && priority < m_queues.size());
+    QMutexLocker locker(&m_mutex);
+    return m_queues[ priority ].limit;
+}
+
+void AdmissionController::setTarget(std::chrono::microseconds target)
+{
+    QMutexLocker locker(&m_mutex);
+    m_target = nsecs(target);
+}
+
+void AdmissionController::setInterval(std::chrono::microseconds interval)
+{
+    QMutexLocker locker(&m_mutex);
+    m_interval = nsecs(interval);
+}
+
+int AdmissionController::enqueue(QString const &method, Task task, Rejection reject)
+{
+    QMutexLocker locker(&m_mutex);
+    Queue &queue = m_queues[ m_priorities.value(method, m_queues.size() - 1) ];
+
+    if (queue.items.size() >= queue.limit) {
+        m_stats.rejected++;
+        return errorCode(ServerExtendedError::Overloaded);
+    }
+
+    queue.items.enqueue(Item{ qMove(task), qMove(reject), m_clock.nsecsElapsed() });
+    m_stats.admitted++;
+    return 0;
+}
+
+bool AdmissionController::dequeue(Task &task)
+{
+    QList<Rejection> shed;
+    bool found = false;
+
+    QMutexLocker locker(&m_mutex);
+    qint64 const now = m_clock.nsecsElapsed();
+    for (auto it = m_queues.begin(); it != m_queues.end() && !found; ++it) {
+        while (!it->items.isEmpty()) {
+            Item item = it->items.dequeue();
+            if (shouldDrop(*it, item, now)) {
+                m_stats.shed++;
+                shed.append(qMove(item.reject));
+                continue;
+            }
+            task = qMove(item.task);
+            found = true;
+            break;
+        }
+    }
+    locker.unlock();
+
+    for (Rejection const &reject : qAsConst(shed))
+        reject(errorCode(ServerExtendedError::Overloaded));
+
+    return found;
+}
+
+AdmissionController::Stats AdmissionController::stats() const
+{
+    QMutexLocker locker(&m_mutex);
+    Stats stats = m_stats;
+    for (Queue const &queue : m_queues)
+        stats.queued += queue.items.size();
+    return stats;
+}
+
+bool AdmissionController::shouldDrop(Queue &queue, Item const &item, qint64 now)
+{
+    bool ok_to_drop = false;
+    if (now - item.enqueued < m_target || queue.items.isEmpty())
+        queue.first_above = 0;
+    else if (!queue.first_above)
+        queue.first_above = now + m_interval;
+    else if (now >= queue.first_above)
+        ok_to_drop = true;
+
+    if (queue.dropping) {
+        if (!ok_to_drop) {
+            queue.dropping = false;
+            return false;
+        }
+        if (now < queue.drop_next)
+            return false;
+
+        queue.drop_count++;
+        queue.drop_next = controlLaw(queue.drop_next, queue.drop_count);
+        return true;
+    }
+
+    if (!ok_to_drop)
+        return false;
+
+    // re-entering dropping state soon after leaving it resumes near previous drop rate
+    queue.dropping = true;
+    queue.drop_count = queue.drop_count > 2 && now - queue.drop_next < 8 * m_interval ? queue.drop_count - 2 : 1;
+    queue.drop_next = controlLaw(now, queue.drop_count);
+    return true;
+}
+
+qint64 AdmissionController::controlLaw(qint64 t, quint32 count) const
+{
+    return t + static_cast<qint64>(static_cast<double>(m_interval) / std::sqrt(static_cast<double>(count)));
+}
+
+} // namespace _2_0
+
+} // namespace qjson
+} // namespace rpc
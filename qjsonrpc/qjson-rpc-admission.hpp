@@ -0,0 +1,99 @@
+#pragma once
+
+#include <qjsonrpc/qjson-rpc.hpp>
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QQueue>
+#include <QString>
+#include <QVector>
+
+#include <chrono>
+#include <functional>
+
+namespace rpc {
+namespace qjson {
+
+inline namespace _2_0 {
+
+/*
+ * Bounded priority queues in front of dispatch. Requests over the queue limit are
+ * rejected at once, requests standing in queue longer than target (CoDel) are shed.
+ * Rejections carry errorCode(ServerExtendedError::Overloaded). Thread safe.
+ **/
+
+class LIBQJSONRPC_EXPORT AdmissionController
+{
+public:
+    using Task = std::function<void()>;
+    using Rejection = std::function<void(int code)>;
+
+    struct Stats
+    {
+        quint64 admitted = 0;
+        quint64 rejected = 0;
+        quint64 shed = 0;
+        int queued = 0;
+    };
+
+    // NOTE: priority 0 is the highest one
+    explicit AdmissionController(int priorities = 3, int queue_limit = 1024);
+
+    [[nodiscard]] int priorities() const;
+
+    // NOTE: methods without explicit priority get the lowest one
+    void setPriority(QString method, int priority);
+    [[nodiscard]] int priority(QString const &method) const;
+
+    void setQueueLimit(int priority, int limit);
+    [[nodiscard]] int queueLimit(int priority) const;
+
+    // CoDel parameters: acceptable standing queue delay and the window it is measured in
+    void setTarget(std::chrono::microseconds target);
+    void setInterval(std::chrono::microseconds interval);
+
+    // NOTE: returns 0 if queued, otherwise error code to answer with (reject is not called then)
+    [[nodiscard]] int enqueue(QString const &method, Task task, Rejection reject);
+
+    // NOTE: returns false if all queues are empty, shed tasks get their reject called
+    [[nodiscard]] bool dequeue(Task &task);
+
+    [[nodiscard]] Stats stats() const;
+
+private:
+    struct Item
+    {
+        Task task;
+        Rejection reject;
+        qint64 enqueued;
+    };
+
+    struct Queue
+    {
+        QQueue<Item> items;
+        int limit = 0;
+
+        // CoDel state
+        qint64 first_above = 0;
+        qint64 drop_next = 0;
+        quint32 drop_count = 0;
+        bool dropping = false;
+    };
+
+    [[nodiscard]] bool shouldDrop(Queue &queue, Item const &item, qint64 now);
+    [[nodiscard]] qint64 controlLaw(qint64 t, quint32 count) const;
+
+    mutable QMutex m_mutex;
+    QElapsedTimer m_clock;
+    QVector<Queue> m_queues;
+    QHash<QString, int> m_priorities;
+    qint64 m_target;
+    qint64 m_interval;
+    Stats m_stats;
+};
+
+} // namespace _2_0
+
+} // namespace qjson
+} // namespace rpc
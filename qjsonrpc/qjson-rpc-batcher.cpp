@@ -0,0 +1,270 @@
+#include <qjsonrpc/qjson-rpc-batcher.hpp>
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QPair>
+
+
+namespace rpc {
+namespace qjson {
+
+inline namespace _2_0 {
+
+CallBatcher::CallBatcher(QObject *parent) : QObject(parent)
+{
+    m_timer.setSingleShot(true);
+    m_timer.setTimerType(Qt::PreciseTimer);
+    m_timer.setInterval(0);
+    connect(&m_timer, &QTimer::timeout, this, &CallBatcher::flush);
+}
+
+void CallBatcher::setWindow(std::chrono::microseconds window)
+{
+    m_window = window;
+    m_timer.setInterval(static_cast<int>(std::chrono::ceil<std::chrono::milliseconds>(window).count()));
+}
+
+std::chrono::microseconds CallBatcher::window() const
+{
+    return m_window;
+}
+
+void CallBatcher::setMaxBatchSize(int size)
+{
+    m_max_batch_size = size;
+    if (m_max_batch_size > 0 && m_queued.size() >= m_max_batch_size)
+        flush();
+}
+
+int CallBatcher::maxBatchSize() const
+{
+    return m_max_batch_size;
+}
+
+void CallBatcher::call(RequestObject const &request, Callback callback)
+{
+    QString key = idKey(request.id());
+    if (m_callbacks.contains(key))
+        qCDebug(rpcQJson2_0()).noquote() << QObject::tr("id is already awaiting response, callback replaced");
+    m_callbacks.insert(qMove(key), qMove(callback));
+
+    enqueue(QJsonDocument(request).toJson(QJsonDocument::Compact), request.id());
+}
+
+void CallBatcher::notify(NotificationObject const &notification)
+{
+    enqueue(QJsonDocument(notification).toJson(QJsonDocument::Compact));
+}
+
+void CallBatcher::flush()
+{
+    m_timer.stop();
+    if (m_queued.isEmpty())
+        return;
+
+    Frame sent{ m_next_frame++, {} };
+    for (Queued const &queued : qAsConst(m_queued)) {
+        if (queued.id.isUndefined())
+            continue;
+        QString const key = idKey(queued.id);
+        sent.ids.insert(key, queued.id);
+        m_frame_of.insert(key, sent.serial);
+    }
+    if (!sent.ids.isEmpty())
+        m_frames.append(qMove(sent));
+
+    // single message goes without batch envelope
+    if (m_queued.size() == 1) {
+        emit frameReady(m_queued.takeFirst().message);
+        return;
+    }
+
+    int size = 1 + m_queued.size();
+    for (Queued const &queued : qAsConst(m_queued))
+        size += queued.message.size();
+
+    QByteArray frame;
+    frame.reserve(size);
+    frame.append('[');
+    for (Queued const &queued : qAsConst(m_queued)) {
+        if (frame.size() > 1)
+            frame.append(',');
+        frame.append(queued.message);
+    }
+    frame.append(']');
+    m_queued.clear();
+
+    emit frameReady(frame);
+}
+
+void CallBatcher::failPending(ErrorObject const &error)
+{
+    m_timer.stop();
+    QList<Queued> const queued = qMove(m_queued);
+    m_queued.clear();
+
+    // NOTE: snapshot, callbacks may call again and flush new frames meanwhile
+    QList<quint64> serials;
+    for (Frame const &frame : qAsConst(m_frames))
+        serials.append(frame.serial);
+    for (quint64 serial : qAsConst(serials))
+        failFrame(serial, error);
+
+    QList<QPair<Callback, QJsonValue>> failed;
+    for (Queued const &call : queued) {
+        if (call.id.isUndefined())
+            continue;
+        if (Callback callback = m_callbacks.take(idKey(call.id)))
+            failed.append(qMakePair(qMove(callback), call.id));
+    }
+    for (auto const &call : qAsConst(failed))
+        call.first(ResponseObject(error, call.second));
+}
+
+int CallBatcher::queuedCount() const
+{
+    return m_queued.size();
+}
+
+int CallBatcher::awaitingCount() const
+{
+    return m_callbacks.size();
+}
+
+int CallBatcher::handleResponse(QByteArray const &message)
+{
+    QJsonParseError je;
+    QJsonDocument const doc = QJsonDocument::fromJson(message, &je);
+    if (je.error != QJsonParseError::NoError)
+        return errorCode(je.error);
+
+    auto const isFrameError = [](ResponseObject const &response) {
+        return response.id().isNull() && response.contains(latin1string::error);
+    };
+
+    if (doc.isObject()) {
+        ResponseObject const response(JsonRpcObject(doc.object()));
+        quint64 serial = 0;
+        if (isFrameError(response) && soleFrame(serial))
+            failFrame(serial, response.error());
+        else
+            route(response);
+        return 0;
+    }
+
+    QJsonArray const batch = doc.array();
+    if (batch.isEmpty())
+        return errorCode(ApplicationError::ResponseInvalid);
+
+    int err = 0;
+    QList<ResponseObject> frame_errors;
+    bool matched = false;
+    quint64 serial = 0;
+    for (QJsonValue const &value : batch) {
+        if (!value.isObject()) {
+            err = errorCode(ApplicationError::ResponseInvalid);
+            continue;
+        }
+
+        ResponseObject const response(JsonRpcObject(value.toObject()));
+        if (isFrameError(response)) {
+            frame_errors.append(response);
+            continue;
+        }
+
+        auto const frame = m_frame_of.constFind(idKey(response.id()));
+        if (!matched && frame != m_frame_of.constEnd()) {
+            serial = *frame;
+            matched = true;
+        }
+        route(response);
+    }
+
+    if (frame_errors.isEmpty())
+        return err;
+
+    // NOTE: batch response is complete, callers of its frame not answered by now never will be
+    if (!matched)
+        matched = soleFrame(serial);
+    if (matched)
+        failFrame(serial, frame_errors.first().error());
+    else
+        for (ResponseObject const &response : qAsConst(frame_errors))
+            emit unmatchedResponse(response);
+    return err;
+}
+
+void CallBatcher::enqueue(QByteArray message, QJsonValue id)
+{
+    m_queued.append(Queued{ qMove(message), qMove(id) });
+
+    if (m_max_batch_size > 0 && m_queued.size() >= m_max_batch_size)
+        flush();
+    else if (!m_timer.isActive())
+        m_timer.start();
+}
+
+void CallBatcher::route(ResponseObject const &response)
+{
+    QString const key = idKey(response.id());
+    Callback const callback = m_callbacks.take(key);
+    if (!callback) {
+        emit unmatchedResponse(response);
+        return;
+    }
+    forget(key);
+    callback(response);
+}
+
+void CallBatcher::forget(QString const &key)
+{
+    if (!m_frame_of.contains(key))
+        return;
+
+    quint64 const serial = m_frame_of.take(key);
+    for (int i = 0; i < m_frames.size(); ++i) {
+        if (m_frames[ i ].serial != serial)
+            continue;
+        m_frames[ i ].ids.remove(key);
+        if (m_frames[ i ].ids.isEmpty())
+            m_frames.removeAt(i);
+        break;
+    }
+}
+
+bool CallBatcher::soleFrame(quint64 &serial) const
+{
+    // NOTE: server may answer frames out of order (e.g. rejects one at once while another still runs),
+    //       so error without id is tied only to the last frame sent while no other one awaits
+    if (m_frames.size() != 1 || m_frames.first().serial + 1 != m_next_frame)
+        return false;
+
+    serial = m_frames.first().serial;
+    return true;
+}
+
+void CallBatcher::failFrame(quint64 serial, ErrorObject const &error)
+{
+    QHash<QString, QJsonValue> ids;
+    for (int i = 0; i < m_frames.size(); ++i) {
+        if (m_frames[ i ].serial == serial) {
+            ids = m_frames.takeAt(i).ids;
+            break;
+        }
+    }
+
+    // NOTE: callbacks are taken first, so they may call again meanwhile
+    QList<QPair<Callback, QJsonValue>> failed;
+    for (auto it = ids.cbegin(); it != ids.cend(); ++it) {
+        m_frame_of.remove(it.key());
+        if (Callback callback = m_callbacks.take(it.key()))
+            failed.append(qMakePair(qMove(callback), it.value()));
+    }
+    for (auto const &call : qAsConst(failed))
+        call.first(ResponseObject(error, call.second));
+}
+
+} // namespace _2_0
+
+} // namespace qjson
+} // namespace rpc
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <qjsonrpc/qjson-rpc.hpp>
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QTimer>
+
+#include <chrono>
+#include <functional>
+
+namespace rpc {
+namespace qjson {
+
+inline namespace _2_0 {
+
+/*
+ * Client side coalescing: calls made within one event loop turn (or window)
+ * leave as a single batch frame, responses are routed back to callers by id.
+ * Error with null id (frame failed to parse or its element is invalid) fails callers
+ * of the frame which are not answered otherwise: in a batch response it is the frame
+ * of the other responses, otherwise only the last frame sent if no other one awaits responses.
+ * Error which can not be tied to a frame goes to unmatchedResponse(), use failPending() then.
+ **/
+
+class LIBQJSONRPC_EXPORT CallBatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    using Callback = std::function<void(ResponseObject const &response)>;
+
+    explicit CallBatcher(QObject *parent = nullptr);
+
+    // NOTE: 0 - flush on the next event loop turn, otherwise rounded up to milliseconds
+    void setWindow(std::chrono::microseconds window);
+    [[nodiscard]] std::chrono::microseconds window() const;
+
+    // NOTE: 0 - unlimited, otherwise flush as soon as the batch holds that many messages
+    void setMaxBatchSize(int size);
+    [[nodiscard]] int maxBatchSize() const;
+
+    void call(RequestObject const &request, Callback callback);
+    void notify(NotificationObject const &notification);
+
+    void flush();
+    // NOTE: every call awaiting response is failed with error, queued messages are dropped (e.g. connection is lost)
+    void failPending(ErrorObject const &error);
+
+    [[nodiscard]] int queuedCount() const;
+    [[nodiscard]] int awaitingCount() const;
+
+    // accepts a single response or a batch of them, returns 0 or error code
+    [[nodiscard]] int handleResponse(QByteArray const &message);
+
+signals:
+    void frameReady(QByteArray frame);
+    void unmatchedResponse(rpc::qjson::ResponseObject response);
+
+private:
+    struct Queued
+    {
+        QByteArray message;
+        // NOTE: undefined for notification
+        QJsonValue id;
+    };
+
+    // calls of one sent frame still awaiting responses, by id key
+    struct Frame
+    {
+        quint64 serial;
+        QHash<QString, QJsonValue> ids;
+    };
+
+    void enqueue(QByteArray message, QJsonValue id = QJsonValue(QJsonValue::Undefined));
+    void route(ResponseObject const &response);
+    void forget(QString const &key);
+    // NOTE: false if error without id can not be tied to a single frame
+    [[nodiscard]] bool soleFrame(quint64 &serial) const;
+    void failFrame(quint64 serial, ErrorObject const &error);
+
+    QTimer m_timer;
+    std::chrono::microseconds m_window{ 0 };
+    int m_max_batch_size = 0;
+    QList<Queued> m_queued;
+    QHash<QString, Callback> m_callbacks;
+    QList<Frame> m_frames;
+    QHash<QString, quint64> m_frame_of;
+    quint64 m_next_frame = 0;
+};
+
+} // namespace _2_0
+
+} // namespace qjson
+} // namespace rpc
@@ -0,0 +1,197 @@
+#include <qjsonrpc/qjson-rpc-broadcast.hpp>
+
+#include <qjsonrpc/qjson-rpc-writer.hpp>
+
+
+namespace rpc {
+namespace qjson {
+
+inline namespace _2_0 {
+
+Broadcaster::Broadcaster(QObject *parent) : QObject(parent) {}
+
+void Broadcaster::setOverflowPolicy(OverflowPolicy policy)
+{
+    m_policy = policy;
+}
+
+Broadcaster::OverflowPolicy Broadcaster::overflowPolicy() const
+{
+    return m_policy;
+}
+
+void Broadcaster::setHighWatermark(qint64 bytes)
+{
+    m_high_watermark = bytes;
+}
+
+qint64 Broadcaster::highWatermark() const
+{
+    return m_high_watermark;
+}
+
+void Broadcaster::setMaxPending(int count)
+{
+    m_max_pending = qMax(count, 0);
+}
+
+int Broadcaster::maxPending() const
+{
+    return m_max_pending;
+}
+
+void Broadcaster::subscribe(QString const &topic, QIODevice *device)
+{
+    Q_ASSERT(device);
+    auto it = m_subscribers.find(device);
+    if (it == m_subscribers.end()) {
+        it = m_subscribers.insert(device, Subscriber());
+        it->written = connect(device, &QIODevice::bytesWritten, this, [this, device] { drain(device); });
+        it->destroyed = connect(device, &QObject::destroyed, this, [this, device] { forget(device); });
+    }
+
+    if (it->topics.contains(topic))
+        return;
+
+    it->topics.insert(topic);
+    m_topics[ topic ].append(device);
+}
+
+void Broadcaster::unsubscribe(QString const &topic, QIODevice *device)
+{
+    auto const it = m_subscribers.find(device);
+    if (it == m_subscribers.end() || !it->topics.remove(topic))
+        return;
+
+    auto const topic_it = m_topics.find(topic);
+    topic_it->removeOne(device);
+    if (topic_it->isEmpty())
+        m_topics.erase(topic_it);
+
+    // NOTE: already queued notifications of the topic are still delivered
+    if (it->topics.isEmpty() && it->pending.isEmpty()) {
+        disconnect(it->written);
+        disconnect(it->destroyed);
+        m_subscribers.erase(it);
+    }
+}
+
+void Broadcaster::unsubscribeAll(QIODevice *device)
+{
+    auto const it = m_subscribers.constFind(device);
+    if (it == m_subscribers.constEnd())
+        return;
+
+    disconnect(it->written);
+    disconnect(it->destroyed);
+    forget(device);
+}
+
+int Broadcaster::subscriberCount(QString const &topic) const
+{
+    return m_topics.value(topic).size();
+}
+
+int Broadcaster::pendingCount(QIODevice *device) const
+{
+    auto const it = m_subscribers.constFind(device);
+    return it == m_subscribers.constEnd() ? 0 : it->pending.size();
+}
+
+int Broadcaster::publish(QString const &topic, NotificationObject const &notification)
+{
+    if (!m_topics.contains(topic))
+        return 0;
+
+    return publishRaw(topic, toJson(notification));
+}
+
+int Broadcaster::publishRaw(QString const &topic, QByteArray const &message)
+{
+    // NOTE: copy, subscriber may go away while written to
+    QList<QIODevice *> const devices = m_topics.value(topic);
+
+    int count = 0;
+    for (QIODevice *device : devices) {
+        auto const it = m_subscribers.find(device);
+        if (it != m_subscribers.end() && deliver(device, *it, topic, message))
+            count++;
+    }
+    if (count)
+        m_stats.published++;
+    return count;
+}
+
+Broadcaster::Stats Broadcaster::stats() const
+{
+    return m_stats;
+}
+
+bool Broadcaster::deliver(QIODevice *device, Subscriber &subscriber, QString const &topic, QByteArray const &message)
+{
+    if (subscriber.pending.isEmpty() && device->bytesToWrite() < m_high_watermark) {
+        writeMessage(device, message);
+        m_stats.delivered++;
+        return true;
+    }
+
+    if (m_policy == OverflowPolicy::Coalesce) {
+        for (Pending &pending : subscriber.pending) {
+            if (pending.topic == topic) {
+                pending.message = message;
+                m_stats.coalesced++;
+                return true;
+            }
+        }
+    }
+
+    if (subscriber.pending.size() >= m_max_pending) {
+        m_stats.dropped++;
+        if (m_policy == OverflowPolicy::Drop || subscriber.pending.isEmpty())
+            return false;
+        subscriber.pending.removeFirst();
+    }
+
+    subscriber.pending.append(Pending{ topic, message });
+    return true;
+}
+
+void Broadcaster::drain(QIODevice *device)
+{
+    auto const it = m_subscribers.find(device);
+    if (it == m_subscribers.end())
+        return;
+
+    while (!it->pending.isEmpty() && device->bytesToWrite() < m_high_watermark) {
+        writeMessage(device, it->pending.takeFirst().message);
+        m_stats.delivered++;
+    }
+
+    if (it->topics.isEmpty() && it->pending.isEmpty()) {
+        disconnect(it->written);
+        disconnect(it->destroyed);
+        m_subscribers.erase(it);
+    }
+}
+
+void Broadcaster::forget(QIODevice *device)
+{
+    auto const it = m_subscribers.find(device);
+    if (it == m_subscribers.end())
+        return;
+
+    for (QString const &topic : qAsConst(it->topics)) {
+        auto const topic_it = m_topics.find(topic);
+        topic_it->removeOne(device);
+        if (topic_it->isEmpty())
+            m_topics.erase(topic_it);
+    }
+
+    m_stats.dropped += static_cast<quint64>(it->pending.size());
+    m_subscribers.erase(it);
+}
+
+} // namespace _2_0
+
+} // namespace qjson
+} // namespace rpc
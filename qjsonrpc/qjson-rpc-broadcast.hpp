@@ -0,0 +1,110 @@
+#pragma once
+
+#include <qjsonrpc/qjson-rpc.hpp>
+
+#include <QByteArray>
+#include <QHash>
+#include <QIODevice>
+#include <QList>
+#include <QObject>
+#include <QSet>
+#include <QString>
+
+namespace rpc {
+namespace qjson {
+
+inline namespace _2_0 {
+
+// defaults of subscriber's pending output bytes considered slow and of its queue length
+constexpr qint64 const broadcast_high_watermark = 1024 * 1024;
+constexpr int const broadcast_max_pending = 64;
+
+
+/*
+ * Topic based notification fan-out. Notification is serialized once, subscribers
+ * share that buffer. Subscriber with more than high watermark bytes pending gets
+ * notifications queued instead, the queue is bounded by overflow policy:
+ *  Drop     - notifications over the limit are dropped,
+ *  Coalesce - queued notification of the same topic is replaced by the newer one,
+ *             the oldest one is dropped over the limit.
+ * Subscribers should live in broadcaster's thread.
+ **/
+
+class LIBQJSONRPC_EXPORT Broadcaster : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum class OverflowPolicy
+    {
+        Drop,
+        Coalesce,
+    };
+
+    struct Stats
+    {
+        // NOTE: notifications written or queued to at least one subscriber
+        quint64 published = 0;
+        quint64 delivered = 0;
+        quint64 coalesced = 0;
+        quint64 dropped = 0;
+    };
+
+    explicit Broadcaster(QObject *parent = nullptr);
+
+    void setOverflowPolicy(OverflowPolicy policy);
+    [[nodiscard]] OverflowPolicy overflowPolicy() const;
+
+    void setHighWatermark(qint64 bytes);
+    [[nodiscard]] qint64 highWatermark() const;
+
+    void setMaxPending(int count);
+    [[nodiscard]] int maxPending() const;
+
+    // NOTE: destroyed devices are unsubscribed automatically
+    void subscribe(QString const &topic, QIODevice *device);
+    void unsubscribe(QString const &topic, QIODevice *device);
+    void unsubscribeAll(QIODevice *device);
+
+    [[nodiscard]] int subscriberCount(QString const &topic) const;
+    [[nodiscard]] int pendingCount(QIODevice *device) const;
+
+    // returns number of subscribers the notification is written or queued to, dropped ones are not counted
+    int publish(QString const &topic, NotificationObject const &notification);
+    // NOTE: message should be serialized compact json
+    int publishRaw(QString const &topic, QByteArray const &message);
+
+    [[nodiscard]] Stats stats() const;
+
+private:
+    struct Pending
+    {
+        QString topic;
+        QByteArray message;
+    };
+
+    struct Subscriber
+    {
+        QSet<QString> topics;
+        QList<Pending> pending;
+        QMetaObject::Connection written;
+        QMetaObject::Connection destroyed;
+    };
+
+    // returns false if notification is dropped
+    bool deliver(QIODevice *device, Subscriber &subscriber, QString const &topic, QByteArray const &message);
+    void drain(QIODevice *device);
+    void forget(QIODevice *device);
+
+    OverflowPolicy m_policy = OverflowPolicy::Coalesce;
+    qint64 m_high_watermark = broadcast_high_watermark;
+    int m_max_pending = broadcast_max_pending;
+    QHash<QString, QList<QIODevice *>> m_topics;
+    QHash<QIODevice *, Subscriber> m_subscribers;
+    Stats m_stats;
+};
+
+} // namespace _2_0
+
+} // namespace qjson
+} // namespace rpc
@@ -0,0 +1,125 @@
+#include <qjsonrpc/qjson-rpc-cache.hpp>
+
+#include <qjsonrpc/qjson-rpc-writer.hpp>
+
+#include <QMutexLocker>
+
+
+namespace rpc {
+namespace qjson {
+
+inline namespace _2_0 {
+
+ResultCache::Policy::Policy(std::chrono::milliseconds ttl, int max_bytes) : ttl(ttl), entries(max_bytes) {}
+
+void ResultCache::setCacheable(QString method, std::chrono::milliseconds ttl, int max_bytes)
+{
+    QMutexLocker locker(&m_mutex);
+    m_policies.insert(qMove(method), QSharedPointer<Policy>::create(ttl, max_bytes));
+}
+
+void ResultCache::setNotCacheable(QString const &method)
+{
+    QMutexLocker locker(&m_mutex);
+    m_policies.remove(method);
+}
+
+bool ResultCache::isCacheable(QString const &method) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_policies.contains(method);
+}
+
+QByteArray ResultCache::lookup(RequestObject const &request)
+{
+    QString const method = request.method();
+    QByteArray const key = callKey(method, request.params());
+
+    QMutexLocker locker(&m_mutex);
+    QSharedPointer<Policy> const policy = m_policies.value(method);
+    if (!policy)
+        return QByteArray();
+
+    Entry const *const entry = policy->entries.object(key);
+    if (!entry) {
+        policy->stats.misses++;
+        return QByteArray();
+    }
+
+    if (entry->expiry.hasExpired()) {
+        policy->entries.remove(key);
+        policy->stats.expirations++;
+        policy->stats.misses++;
+        return QByteArray();
+    }
+
+    policy->stats.hits++;
+    QByteArray const result = entry->result;
+    locker.unlock();
+
+    return resultResponseJson(request.id(), result);
+}
+
+void ResultCache::store(RequestObject const &request, ResponseObject const &response)
+{
+    if (!response.contains(latin1string::result))
+        return;
+
+    QString const method = request.method();
+    QByteArray key = callKey(method, request.params());
+    QByteArray result = toJson(response.result());
+    int const cost = key.size() + result.size();
+
+    QMutexLocker locker(&m_mutex);
+    QSharedPointer<Policy> const policy = m_policies.value(method);
+    if (!policy)
+        return;
+
+    policy->entries.remove(key);
+    int const size_before = policy->entries.size();
+    auto *const entry = new Entry{ qMove(result), QDeadlineTimer(policy->ttl) };
+    // NOTE: QCache takes ownership even if the entry does not fit
+    bool const inserted = policy->entries.insert(qMove(key), entry, cost);
+    int const evicted = size_before + (inserted ? 1 : 0) - policy->entries.size();
+    policy->stats.evictions += static_cast<quint64>(evicted);
+}
+
+void ResultCache::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    for (QSharedPointer<Policy> const &policy : qAsConst(m_policies))
+        policy->entries.clear();
+}
+
+ResultCache::Stats ResultCache::stats() const
+{
+    QMutexLocker locker(&m_mutex);
+    Stats total;
+    for (QSharedPointer<Policy> const &policy : qAsConst(m_policies)) {
+        total.hits += policy->stats.hits;
+        total.misses += policy->stats.misses;
+        total.evictions += policy->stats.evictions;
+        total.expirations += policy->stats.expirations;
+        total.bytes += policy->entries.totalCost();
+        total.entries += policy->entries.size();
+    }
+    return total;
+}
+
+ResultCache::Stats ResultCache::stats(QString const &method) const
+{
+    QMutexLocker locker(&m_mutex);
+    QSharedPointer<Policy> const policy = m_policies.value(method);
+    if (!policy)
+        return Stats();
+
+    Stats stats = policy->stats;
+    stats.bytes = policy->entries.totalCost();
+    stats.entries = policy->entries.size();
+    return stats;
+}
+
+} // namespace _2_0
+
+} // namespace qjson
+} // namespace rpc
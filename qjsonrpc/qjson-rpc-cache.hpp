@@ -0,0 +1,75 @@
+#pragma once
+
+#include <qjsonrpc/qjson-rpc.hpp>
+
+#include <QByteArray>
+#include <QCache>
+#include <QDeadlineTimer>
+#include <QHash>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QString>
+
+#include <chrono>
+
+namespace rpc {
+namespace qjson {
+
+inline namespace _2_0 {
+
+/*
+ * Memoization of idempotent methods: serialized results keyed by callKey(),
+ * least recently used entries are evicted when method's byte budget is exceeded.
+ * Error responses are never cached. Thread safe.
+ **/
+
+class LIBQJSONRPC_EXPORT ResultCache
+{
+public:
+    struct Stats
+    {
+        quint64 hits = 0;
+        quint64 misses = 0;
+        quint64 evictions = 0;
+        quint64 expirations = 0;
+        int bytes = 0;
+        int entries = 0;
+    };
+
+    void setCacheable(QString method, std::chrono::milliseconds ttl, int max_bytes);
+    void setNotCacheable(QString const &method);
+    [[nodiscard]] bool isCacheable(QString const &method) const;
+
+    // NOTE: returns serialized response with request's id spliced in, null on miss
+    [[nodiscard]] QByteArray lookup(RequestObject const &request);
+    void store(RequestObject const &request, ResponseObject const &response);
+
+    void clear();
+
+    [[nodiscard]] Stats stats() const;
+    [[nodiscard]] Stats stats(QString const &method) const;
+
+private:
+    struct Entry
+    {
+        QByteArray result;
+        QDeadlineTimer expiry;
+    };
+
+    struct Policy
+    {
+        Policy(std::chrono::milliseconds ttl, int max_bytes);
+
+        std::chrono::milliseconds ttl;
+        QCache<QByteArray, Entry> entries;
+        Stats stats;
+    };
+
+    mutable QMutex m_mutex;
+    QHash<QString, QSharedPointer<Policy>> m_policies;
+};
+
+} // namespace _2_0
+
+} // namespace qjson
+} // namespace rpc
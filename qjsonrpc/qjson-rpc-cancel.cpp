@@ -0,0 +1,115 @@
+#include <qjsonrpc/qjson-rpc-cancel.hpp>
+
+#include <limits>
+
+
+namespace rpc {
+namespace qjson {
+
+inline namespace _2_0 {
+
+CancellationToken::CancellationToken(QDeadlineTimer deadline) : m_state(QSharedPointer<State>::create())
+{
+    setDeadline(deadline);
+}
+
+void CancellationToken::cancel()
+{
+    m_state->cancelled.storeRelease(1);
+}
+
+void CancellationToken::setDeadline(QDeadlineTimer deadline)
+{
+    // NOTE: forever deadline is std::numeric_limits<qint64>::max()
+    m_state->deadline.storeRelease(deadline.deadlineNSecs());
+}
+
+bool CancellationToken::isCancelled() const
+{
+    return m_state->cancelled.loadAcquire() || isExpired();
+}
+
+bool CancellationToken::isExpired() const
+{
+    qint64 const deadline = m_state->deadline.loadAcquire();
+    if (deadline == std::numeric_limits<qint64>::max())
+        return false;
+
+    return QDeadlineTimer::current(Qt::PreciseTimer).deadlineNSecs() >= deadline;
+}
+
+qint64 CancellationToken::remainingTime() const
+{
+    qint64 const deadline = m_state->deadline.loadAcquire();
+    if (deadline == std::numeric_limits<qint64>::max())
+        return -1;
+
+    qint64 const remaining = deadline - QDeadlineTimer::current(Qt::PreciseTimer).deadlineNSecs();
+    return qMax<qint64>(0, remaining / 1'000'000);
+}
+
+QDeadlineTimer CancellationToken::deadline() const
+{
+    qint64 const deadline = m_state->deadline.loadAcquire();
+    if (deadline == std::numeric_limits<qint64>::max())
+        return QDeadlineTimer(QDeadlineTimer::Forever);
+
+    QDeadlineTimer timer(Qt::PreciseTimer);
+    timer.setPreciseDeadline(deadline / 1'000'000'000, deadline % 1'000'000'000);
+    return timer;
+}
+
+int CancellationToken::reason() const
+{
+    if (m_state->cancelled.loadAcquire())
+        return errorCode(ServerExtendedError::Cancelled);
+
+    if (isExpired())
+        return errorCode(ServerExtendedError::DeadlineExceeded);
+
+    return 0;
+}
+
+
+NotificationObject cancelNotification(QJsonValue id)
+{
+    return NotificationObject(latin1string::rpc_cancel, QJsonObject({ { latin1string::id, qMove(id) } }));
+}
+
+NotificationObject deadlineNotification(QJsonValue id, std::chrono::milliseconds timeout)
+{
+    return NotificationObject(latin1string::rpc_cancel,
+                              QJsonObject({ { latin1string::id, qMove(id) },
+                                            { latin1string::timeout, static_cast<qint64>(timeout.count()) } }));
+}
+
+bool isCancelNotification(QJsonObject const &jo)
+{
+    if (!isJsonRpcObject(jo) || jo.contains(latin1string::id))
+        return false;
+
+    if (jo.value(latin1string::method).toString() != latin1string::rpc_cancel)
+        return false;
+
+    QJsonValue const params_val = jo.value(latin1string::params);
+    if (!params_val.isObject())
+        return false;
+
+    QJsonObject const params = params_val.toObject();
+    if (!isIdFieldValid(params))
+        return false;
+
+    // NOTE: negative one would mean no deadline at all, and anything else would expire at once
+    if (params.contains(latin1string::timeout)) {
+        QJsonValue const timeout_val = params.value(latin1string::timeout);
+        if (!timeout_val.isDouble() || timeout_val.toDouble() < 0 || !isInteger(timeout_val.toDouble()))
+            return false;
+    }
+
+    return true;
+}
+
+} // namespace _2_0
+
+} // namespace qjson
+} // namespace rpc
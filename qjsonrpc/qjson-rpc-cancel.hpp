@@ -0,0 +1,66 @@
+#pragma once
+
+#include <qjsonrpc/qjson-rpc.hpp>
+
+#include <QAtomicInteger>
+#include <QDeadlineTimer>
+#include <QSharedPointer>
+
+#include <chrono>
+
+namespace rpc {
+namespace qjson {
+
+inline namespace _2_0 {
+
+/*
+ * Shared cancellation state of one request: copies observe the same state.
+ * Handlers poll isCancelled() to drop work nobody waits for anymore.
+ **/
+
+class LIBQJSONRPC_EXPORT CancellationToken
+{
+public:
+    explicit CancellationToken(QDeadlineTimer deadline = QDeadlineTimer(QDeadlineTimer::Forever));
+
+    void cancel();
+    void setDeadline(QDeadlineTimer deadline);
+
+    // NOTE: cancelled explicitly or deadline is passed
+    [[nodiscard]] bool isCancelled() const;
+    [[nodiscard]] bool isExpired() const;
+
+    // NOTE: -1 if there is no deadline
+    [[nodiscard]] qint64 remainingTime() const;
+    [[nodiscard]] QDeadlineTimer deadline() const;
+
+    // NOTE: ServerExtendedError code matching the reason, 0 if not cancelled
+    [[nodiscard]] int reason() const;
+
+private:
+    struct State
+    {
+        QAtomicInteger<int> cancelled{ 0 };
+        QAtomicInteger<qint64> deadline{ 0 };
+    };
+
+    QSharedPointer<State> m_state;
+};
+
+
+/*
+ * rpc.cancel - reserved notification, params: { "id": <request id>[, "timeout": <msecs>] }
+ * without timeout request is cancelled at once, with timeout it gets deadline counted from receipt;
+ * timeout is a non-negative integer, server's default timeout caps it.
+ * Should be sent after the request it refers to.
+ **/
+
+[[nodiscard]] LIBQJSONRPC_EXPORT NotificationObject cancelNotification(QJsonValue id);
+[[nodiscard]] LIBQJSONRPC_EXPORT NotificationObject deadlineNotification(QJsonValue id, std::chrono::milliseconds timeout);
+
+[[nodiscard]] LIBQJSONRPC_EXPORT bool isCancelNotification(QJsonObject const &jo);
+
+} // namespace _2_0
+
+} // namespace qjson
+} // namespace rpc
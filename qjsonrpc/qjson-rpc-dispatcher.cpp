@@ -0,0 +1,670 @@
+#include <qjsonrpc/qjson-rpc-dispatcher.hpp>
+
+#include <qjsonrpc/qjson-rpc-cache.hpp>
+#include <qjsonrpc/qjson-rpc-parallel.hpp>
+#include <qjsonrpc/qjson-rpc-peek.hpp>
+#include <qjsonrpc/qjson-rpc-writer.hpp>
+
+#include <QBuffer>
+#include <QFutureWatcher>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QList>
+#include <QMutexLocker>
+#include <QPointer>
+#include <QRunnable>
+#include <QSharedPointer>
+#include <QThread>
+
+
+namespace rpc {
+namespace qjson {
+
+inline namespace _2_0 {
+
+namespace {
+
+[[nodiscard]] QByteArray errorResponse(int code, QJsonValue id = QJsonValue())
+{
+    return toJson(ResponseObject(ErrorObject(code), qMove(id)));
+}
+
+[[nodiscard]] QString tokenKey(QObject const *session, QJsonValue const &id)
+{
+    return QString::number(reinterpret_cast<quintptr>(session), 16) + idKey(id);
+}
+
+/*
+ * Device a response goes to, seen from any thread: its thread is captured at dispatch time, calls are posted
+ * there and the device is looked at only in that thread, so nothing runs once it is destroyed
+ * and it is never touched while being destroyed elsewhere.
+ **/
+
+class DeviceContext
+{
+public:
+    explicit DeviceContext(QIODevice *device) : m_device(device), m_thread(device ? device->thread() : nullptr) {}
+
+    template <typename Function>
+    void run(Function function) const
+    {
+        if (!m_thread)
+            return;
+
+        if (m_thread == QThread::currentThread()) {
+            if (m_device)
+                function(m_device.data());
+            return;
+        }
+
+        // NOTE: carrier is created here and handed over to device's thread, it is deleted after the call
+        auto *const carrier = new QObject;
+        carrier->moveToThread(m_thread);
+        QMetaObject::invokeMethod(
+            carrier,
+            [carrier, device = m_device, function = qMove(function)]() mutable {
+                carrier->deleteLater();
+                if (device)
+                    function(device.data());
+            },
+            Qt::QueuedConnection);
+    }
+
+private:
+    QPointer<QIODevice> m_device;
+    QThread *m_thread;
+};
+
+void writeTo(QIODevice *device, QByteArray const &message)
+{
+    DeviceContext(device).run([message](QIODevice *target) { writeMessage(target, message); });
+}
+
+class FunctionRunnable : public QRunnable
+{
+public:
+    explicit FunctionRunnable(std::function<void()> function) : m_function(qMove(function)) {}
+
+    void run() override { m_function(); }
+
+private:
+    std::function<void()> m_function;
+};
+
+// NOTE: completed in device's thread only
+class BatchReply
+{
+public:
+    BatchReply(QIODevice *device, bool streaming, int pending)
+        : m_writer(device), m_pending(pending), m_streaming(streaming)
+    {
+    }
+
+    void complete(QByteArray const &response)
+    {
+        if (!response.isEmpty()) {
+            if (m_streaming)
+                m_writer.write(response);
+            else
+                m_collected.append(response);
+        }
+
+        if (--m_pending)
+            return;
+
+        for (QByteArray const &collected : qAsConst(m_collected))
+            m_writer.write(collected);
+        m_collected.clear();
+        m_writer.finish();
+    }
+
+private:
+    BatchResponseWriter m_writer;
+    QList<QByteArray> m_collected;
+    int m_pending;
+    bool m_streaming;
+};
+
+} // namespace
+
+
+void Dispatcher::addMethod(QString method, Handler handler)
+{
+    addMethod(qMove(method), [handler = qMove(handler)](RequestObject const &request, CancellationToken const &) {
+        return handler(request);
+    });
+}
+
+void Dispatcher::addMethod(QString method, CancellableHandler handler)
+{
+    removeMethod(method);
+    m_methods.insert(qMove(method), qMove(handler));
+}
+
+void Dispatcher::addAsyncMethod(QString method, AsyncHandler handler)
+{
+    removeMethod(method);
+    m_async_methods.insert(qMove(method), qMove(handler));
+}
+
+void Dispatcher::addAsyncMethod(QString method, FutureHandler handler)
+{
+    addAsyncMethod(qMove(method), [handler = qMove(handler)](RequestObject const &request, ResponsePromise promise,
+                                                             CancellationToken const &) {
+        auto *const watcher = new QFutureWatcher<QJsonValue>;
+        QObject::connect(watcher, &QFutureWatcherBase::finished, watcher, [watcher, promise]() mutable {
+            QFuture<QJsonValue> future = watcher->future();
+            watcher->deleteLater();
+
+            // NOTE: future failed with exception is canceled too, waitForFinished() rethrows the exception
+            QT_TRY {
+                future.waitForFinished();
+            } QT_CATCH (...) {
+                promise.reject(ErrorObject(errorCode(ServerError::Internal)));
+                return;
+            }
+
+            if (future.isCanceled() || !future.resultCount()) {
+                promise.reject(ErrorObject(errorCode(ServerExtendedError::Cancelled)));
+                return;
+            }
+            promise.resolve(future.result());
+        });
+        watcher->setFuture(handler(request));
+    });
+}
+
+void Dispatcher::addStreamingMethod(QString method, StreamingHandler handler)
+{
+    removeMethod(method);
+    m_streaming_methods.insert(qMove(method), qMove(handler));
+}
+
+void Dispatcher::removeMethod(QString const &method)
+{
+    m_methods.remove(method);
+    m_async_methods.remove(method);
+    m_streaming_methods.remove(method);
+}
+
+bool Dispatcher::hasMethod(QString const &method) const
+{
+    return m_methods.contains(method) || m_async_methods.contains(method) || m_streaming_methods.contains(method);
+}
+
+void Dispatcher::setBatchStreaming(bool enabled)
+{
+    m_batch_streaming = enabled;
+}
+
+bool Dispatcher::isBatchStreaming() const
+{
+    return m_batch_streaming;
+}
+
+void Dispatcher::setResultCache(ResultCache *cache)
+{
+    m_cache = cache;
+}
+
+ResultCache *Dispatcher::resultCache() const
+{
+    return m_cache;
+}
+
+void Dispatcher::setCoalescing(bool enabled)
+{
+    m_coalescing = enabled;
+}
+
+bool Dispatcher::isCoalescing() const
+{
+    return m_coalescing;
+}
+
+InflightGroup const &Dispatcher::inflight() const
+{
+    return m_inflight;
+}
+
+void Dispatcher::setThreadPool(QThreadPool *pool)
+{
+    m_pool = pool;
+}
+
+QThreadPool *Dispatcher::threadPool() const
+{
+    return m_pool;
+}
+
+void Dispatcher::setAdmissionController(AdmissionController *controller)
+{
+    m_admission = controller;
+}
+
+AdmissionController *Dispatcher::admissionController() const
+{
+    return m_admission;
+}
+
+void Dispatcher::setDefaultTimeout(std::chrono::milliseconds timeout)
+{
+    m_default_timeout = timeout;
+}
+
+std::chrono::milliseconds Dispatcher::defaultTimeout() const
+{
+    return m_default_timeout;
+}
+
+void Dispatcher::setLimits(JsonLimits const &limits)
+{
+    m_limits = limits;
+    m_limited = true;
+}
+
+JsonLimits Dispatcher::limits() const
+{
+    return m_limits;
+}
+
+void Dispatcher::setParallelParseThreshold(int bytes)
+{
+    m_parallel_threshold = qMax(bytes, 0);
+}
+
+int Dispatcher::parallelParseThreshold() const
+{
+    return m_parallel_threshold;
+}
+
+void Dispatcher::dispatch(QByteArray const &message, QIODevice *device)
+{
+    if (m_limited) {
+        if (int err = checkLimits(message, m_limits)) {
+            writeTo(device, errorResponse(err));
+            return;
+        }
+    }
+
+    if (m_parallel_threshold && message.size() >= m_parallel_threshold && dispatchLarge(message, device))
+        return;
+
+    QJsonParseError je;
+    QJsonDocument const doc = QJsonDocument::fromJson(message, &je);
+    if (je.error != QJsonParseError::NoError) {
+        writeTo(device, errorResponse(errorCode(je.error)));
+        return;
+    }
+
+    if (doc.isObject()) {
+        dispatchObject(doc.object(), device);
+        return;
+    }
+
+    QJsonArray const batch = doc.array();
+    if (batch.isEmpty()) {
+        writeTo(device, errorResponse(errorCode(ServerError::RequestInvalid)));
+        return;
+    }
+
+    DeviceContext const context(device);
+    auto const reply = QSharedPointer<BatchReply>::create(device, m_batch_streaming, batch.size());
+    for (QJsonValue const &element : batch)
+        invoke(
+            element,
+            [context, reply](QByteArray const &response) {
+                context.run([reply, response](QIODevice *) { reply->complete(response); });
+            },
+            device);
+}
+
+void Dispatcher::dispatchObject(QJsonObject const &jo, QIODevice *device)
+{
+    DeviceContext const context(device);
+    process(
+        jo,
+        [context](QByteArray const &response) {
+            if (response.isEmpty())
+                return;
+            context.run([response](QIODevice *target) { writeMessage(target, response); });
+        },
+        device, device);
+}
+
+bool Dispatcher::dispatchLarge(QByteArray const &message, QIODevice *device)
+{
+    // NOTE: anything the rebuilt envelope would lose (extra or repeated members) goes the usual way,
+    //       so validation does not depend on message size
+    EnvelopePeek peek;
+    if (peekEnvelope(message, peek, m_limits) || peek.batch || peek.extra_members || !peek.hasParams() ||
+        message.at(peek.params_begin) != '[')
+        return false;
+
+    QJsonArray params;
+    if (int err = parseArray(message, peek.params_begin, peek.params_end, params, m_pool)) {
+        writeTo(device, errorResponse(err));
+        return true;
+    }
+
+    // NOTE: envelope fields are valid json as peeked, so they are spliced back as is
+    QByteArray envelope = "{\"jsonrpc\":\"" + peek.jsonrpc + "\",\"method\":\"" + peek.method + '"';
+    if (!peek.isNotification())
+        envelope += ",\"id\":" + peek.id;
+    envelope += '}';
+
+    QJsonObject jo = QJsonDocument::fromJson(envelope).object();
+    jo.insert(latin1string::params, params);
+    dispatchObject(jo, device);
+    return true;
+}
+
+void Dispatcher::invoke(QJsonValue const &message, Completion done, QObject const *session)
+{
+    process(message, qMove(done), session, nullptr);
+}
+
+void Dispatcher::process(QJsonValue const &message, Completion done, QObject const *session, QIODevice *direct)
+{
+    if (!message.isObject()) {
+        done(errorResponse(errorCode(ServerError::RequestInvalid)));
+        return;
+    }
+
+    RequestObject const request(JsonRpcObject(message.toObject()));
+    bool const notification = !request.contains(latin1string::id);
+
+    if (isCancelNotification(request)) {
+        cancel(request.params().toObject(), session);
+        done(QByteArray());
+        return;
+    }
+
+    if (int err = checkRequest(request, notification)) {
+        done(notification ? QByteArray() : errorResponse(err, request.isIdFieldValid() ? request.id() : QJsonValue()));
+        return;
+    }
+
+    CancellableHandler const handler = m_methods.value(request.method());
+    AsyncHandler const async = handler ? AsyncHandler() : m_async_methods.value(request.method());
+    if (!handler && !async) {
+        if (StreamingHandler const streaming = m_streaming_methods.value(request.method()))
+            stream(request, streaming, notification, session, direct, qMove(done));
+        else
+            done(notification ? QByteArray() : errorResponse(errorCode(ServerError::MethodNotFound), request.id()));
+        return;
+    }
+
+    bool const cacheable = !notification && m_cache && m_cache->isCacheable(request.method());
+    if (cacheable) {
+        QByteArray cached = m_cache->lookup(request);
+        if (!cached.isNull()) {
+            done(cached);
+            return;
+        }
+    }
+
+    CancellationToken token = makeToken();
+    QString const token_key = notification ? QString() : tokenKey(session, request.id());
+    if (!notification)
+        registerToken(token_key, token);
+
+    bool const coalescing = !notification && m_coalescing;
+    QByteArray const call_key = coalescing ? callKey(request.method(), request.params()) : QByteArray();
+    if (coalescing) {
+        auto follower_done = [this, token_key, done](QByteArray const &response) {
+            unregisterToken(token_key);
+            done(response);
+        };
+        if (!m_inflight.join(request, qMove(follower_done))) {
+            joinGroup(call_key, token_key);
+            return;
+        }
+        // NOTE: handler observes the group, so cancelling the leader alone does not fail the followers
+        token = openGroup(call_key, token_key, token);
+    }
+
+    auto reject = [this, request, notification, coalescing, call_key, token_key, done](int code) {
+        if (notification) {
+            done(QByteArray());
+            return;
+        }
+        unregisterToken(token_key);
+        ResponseObject const response(ErrorObject(code), request.id());
+        if (coalescing) {
+            closeGroup(call_key);
+            m_inflight.finish(request, response);
+        }
+        done(toJson(response));
+    };
+
+    auto finish = [this, request, notification, cacheable, coalescing, call_key, token_key,
+                   done](ResponseObject const &response) {
+        if (notification) {
+            done(QByteArray());
+            return;
+        }
+
+        unregisterToken(token_key);
+        if (cacheable)
+            m_cache->store(request, response);
+        if (coalescing) {
+            closeGroup(call_key);
+            m_inflight.finish(request, response);
+        }
+        done(toJson(response));
+    };
+
+    if (async) {
+        async(request, ResponsePromise(request.id(), qMove(finish)), token);
+        return;
+    }
+
+    auto run = [handler, request, token, reject, finish] {
+        // expired while queued, nobody waits for it anymore
+        if (int code = token.reason()) {
+            reject(code);
+            return;
+        }
+
+        finish(handler(request, token));
+    };
+
+    schedule(request.method(), qMove(run), qMove(reject));
+}
+
+void Dispatcher::stream(RequestObject const &request, StreamingHandler const &handler, bool notification,
+                        QObject const *session, QIODevice *direct, Completion done)
+{
+    CancellationToken const token = makeToken();
+    QString const token_key = notification ? QString() : tokenKey(session, request.id());
+    if (!notification)
+        registerToken(token_key, token);
+
+    // NOTE: stream writes device and takes part in its ordering, both in device's thread only,
+    //       dispatched elsewhere the result is buffered and written through done
+    if (direct && direct->thread() != QThread::currentThread())
+        direct = nullptr;
+
+    QIODevice *device = notification ? nullptr : direct;
+    QBuffer *buffer = nullptr;
+    if (!notification && !direct) {
+        buffer = new QBuffer;
+        buffer->open(QIODevice::WriteOnly);
+        device = buffer;
+    }
+
+    auto *const result_stream = new ResultStream(request.id(), device, direct);
+    QObject::connect(result_stream, &ResultStream::finished, result_stream,
+                     [this, result_stream, buffer, token_key, notification, done] {
+                         if (!notification)
+                             unregisterToken(token_key);
+                         done(buffer ? buffer->data() : QByteArray());
+                         delete buffer;
+                         result_stream->deleteLater();
+                     });
+
+    handler(request, result_stream, token);
+}
+
+void Dispatcher::schedule(QString const &method, AdmissionController::Task run, AdmissionController::Rejection reject)
+{
+    if (m_admission) {
+        if (int code = m_admission->enqueue(method, qMove(run), reject)) {
+            reject(code);
+            return;
+        }
+        // queued task is picked by priority when a worker is free, not necessarily this one
+        run = [admission = m_admission] {
+            AdmissionController::Task task;
+            if (admission->dequeue(task))
+                task();
+        };
+    }
+
+    if (m_pool)
+        m_pool->start(new FunctionRunnable(qMove(run)));
+    else
+        run();
+}
+
+CancellationToken Dispatcher::makeToken() const
+{
+    if (m_default_timeout.count() <= 0)
+        return CancellationToken();
+
+    return CancellationToken(QDeadlineTimer(m_default_timeout));
+}
+
+void Dispatcher::cancel(QJsonObject const &params, QObject const *session)
+{
+    QString const key = tokenKey(session, params.value(latin1string::id));
+
+    QMutexLocker locker(&m_tokens_mutex);
+    auto const it = m_tokens.find(key);
+    if (it == m_tokens.end())
+        return;
+
+    // NOTE: finished or unknown request is ignored; timeout is checked by isCancelNotification(),
+    //       client may shorten server's default deadline, but never lift it
+    if (params.contains(latin1string::timeout)) {
+        auto timeout = static_cast<qint64>(params.value(latin1string::timeout).toDouble());
+        if (m_default_timeout.count())
+            timeout = qMin<qint64>(timeout, m_default_timeout.count());
+        it->setDeadline(QDeadlineTimer(timeout));
+    } else {
+        it->cancel();
+    }
+
+    auto const grouped = m_grouped.constFind(key);
+    if (grouped != m_grouped.constEnd()) {
+        auto const group = m_groups.find(*grouped);
+        if (group != m_groups.end())
+            updateGroup(*group);
+    }
+}
+
+void Dispatcher::registerToken(QString const &key, CancellationToken const &token)
+{
+    QMutexLocker locker(&m_tokens_mutex);
+    m_tokens.insert(key, token);
+}
+
+void Dispatcher::unregisterToken(QString const &key)
+{
+    QMutexLocker locker(&m_tokens_mutex);
+    m_tokens.remove(key);
+}
+
+CancellationToken Dispatcher::openGroup(QByteArray const &call_key, QString const &key,
+                                        CancellationToken const &token)
+{
+    CancellationToken const execution(token.deadline());
+
+    QMutexLocker locker(&m_tokens_mutex);
+    m_groups.insert(call_key, CallGroup{ execution, QStringList(key) });
+    m_grouped.insert(key, call_key);
+    return execution;
+}
+
+void Dispatcher::joinGroup(QByteArray const &call_key, QString const &key)
+{
+    QMutexLocker locker(&m_tokens_mutex);
+    auto const group = m_groups.find(call_key);
+    // NOTE: leader may finish meanwhile, follower is completed by it anyway
+    if (group == m_groups.end())
+        return;
+
+    group->members.append(key);
+    m_grouped.insert(key, call_key);
+    updateGroup(*group);
+}
+
+void Dispatcher::closeGroup(QByteArray const &call_key)
+{
+    QMutexLocker locker(&m_tokens_mutex);
+    CallGroup const group = m_groups.take(call_key);
+    for (QString const &key : group.members)
+        m_grouped.remove(key);
+}
+
+void Dispatcher::updateGroup(CallGroup &group) const
+{
+    int const cancelled = errorCode(ServerExtendedError::Cancelled);
+
+    bool waiting = false;
+    QDeadlineTimer latest(0);
+    for (QString const &key : qAsConst(group.members)) {
+        // NOTE: finished caller has no token anymore and waits for nothing
+        auto const it = m_tokens.constFind(key);
+        if (it == m_tokens.constEnd() || it->reason() == cancelled)
+            continue;
+
+        waiting = true;
+        QDeadlineTimer const deadline = it->deadline();
+        if (deadline.isForever() || deadline.deadlineNSecs() > latest.deadlineNSecs())
+            latest = deadline;
+        if (latest.isForever())
+            break;
+    }
+
+    if (waiting)
+        group.execution.setDeadline(latest);
+    else
+        group.execution.cancel();
+}
+
+int Dispatcher::checkRequest(RequestObject const &request, bool notification) const
+{
+    if (notification) {
+        NotificationObject const notification_obj(static_cast<JsonRpcObject const &>(request));
+        if (int err = notification_obj.checkJsonRpcField())
+            return err;
+        if (int err = notification_obj.checkMethodField())
+            return err;
+        if (notification_obj.contains(latin1string::params))
+            if (int err = notification_obj.checkParamsField())
+                return err;
+        if (!notification_obj.isValid())
+            return errorCode(ServerError::NotificationInvalid);
+        return 0;
+    }
+
+    if (int err = request.checkJsonRpcField())
+        return err;
+    if (int err = request.checkIdField())
+        return err;
+    if (int err = request.checkMethodField())
+        return err;
+    if (request.contains(latin1string::params))
+        if (int err = request.checkParamsField())
+            return err;
+    if (!request.isValid())
+        return errorCode(ServerError::RequestInvalid);
+    return 0;
+}
+
+} // namespace _2_0
+
+} // namespace qjson
+} // namespace rpc
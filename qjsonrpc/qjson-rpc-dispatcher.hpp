@@ -0,0 +1,168 @@
+#pragma once
+
+#include <qjsonrpc/qjson-rpc-admission.hpp>
+#include <qjsonrpc/qjson-rpc-cancel.hpp>
+#include <qjsonrpc/qjson-rpc-inflight.hpp>
+#include <qjsonrpc/qjson-rpc-promise.hpp>
+#include <qjsonrpc/qjson-rpc-scanner.hpp>
+#include <qjsonrpc/qjson-rpc-stream.hpp>
+#include <qjsonrpc/qjson-rpc.hpp>
+
+#include <QByteArray>
+#include <QFuture>
+#include <QHash>
+#include <QIODevice>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+
+#include <chrono>
+#include <functional>
+
+namespace rpc {
+namespace qjson {
+
+inline namespace _2_0 {
+
+class ResultCache;
+
+
+/*
+ * Server side: routes requests and notifications to method handlers,
+ * writes responses (single or batch) back to the device the message came from.
+ * Methods should be registered before dispatching starts, after that dispatch()
+ * may be called from several threads, responses are written in the device's thread.
+ * rpc.cancel notifications are handled by dispatcher itself.
+ **/
+
+class LIBQJSONRPC_EXPORT Dispatcher
+{
+public:
+    // NOTE: response returned for a notification is dropped
+    using Handler = std::function<ResponseObject(RequestObject const &request)>;
+    using CancellableHandler = std::function<ResponseObject(RequestObject const &request, CancellationToken const &token)>;
+    using AsyncHandler =
+        std::function<void(RequestObject const &request, ResponsePromise promise, CancellationToken const &token)>;
+    using FutureHandler = std::function<QFuture<QJsonValue>(RequestObject const &request)>;
+    using StreamingHandler =
+        std::function<void(RequestObject const &request, ResultStream *stream, CancellationToken const &token)>;
+
+    // NOTE: response is serialized compact json object, empty for notifications
+    using Completion = std::function<void(QByteArray const &response)>;
+
+    virtual ~Dispatcher() = default;
+
+    void addMethod(QString method, Handler handler);
+    void addMethod(QString method, CancellableHandler handler);
+
+    // NOTE: handler starts in dispatching thread and holds no thread afterwards, response goes once promise
+    //       is settled; admission control does not apply
+    void addAsyncMethod(QString method, AsyncHandler handler);
+    // NOTE: result of the future is the result of the call, canceled or failed one is answered with error;
+    //       dispatching thread should run event loop
+    void addAsyncMethod(QString method, FutureHandler handler);
+
+    // NOTE: handler runs in dispatching thread and should finish() or fail() the stream, possibly later on.
+    //       Single request dispatched in device's thread streams straight to the device, otherwise
+    //       (inside a batch or from another thread) result is buffered until finished;
+    //       other responses to the device are held meanwhile, see writeMessage()
+    void addStreamingMethod(QString method, StreamingHandler handler);
+    void removeMethod(QString const &method);
+    [[nodiscard]] bool hasMethod(QString const &method) const;
+
+    // NOTE: streaming batch elements are written as soon as they complete instead of whole array at the end
+    void setBatchStreaming(bool enabled);
+    [[nodiscard]] bool isBatchStreaming() const;
+
+    // NOTE: cache is not owned, cacheable methods are configured on the cache itself
+    void setResultCache(ResultCache *cache);
+    [[nodiscard]] ResultCache *resultCache() const;
+
+    // NOTE: identical requests arriving while one is executing wait for its result instead of running again;
+    //       the call is cancelled only once every caller has cancelled it
+    void setCoalescing(bool enabled);
+    [[nodiscard]] bool isCoalescing() const;
+    [[nodiscard]] InflightGroup const &inflight() const;
+
+    // NOTE: handlers run on the pool instead of dispatching thread, dispatcher should outlive pool's tasks
+    void setThreadPool(QThreadPool *pool);
+    [[nodiscard]] QThreadPool *threadPool() const;
+
+    // NOTE: controller is not owned, it is meaningful with thread pool only
+    void setAdmissionController(AdmissionController *controller);
+    [[nodiscard]] AdmissionController *admissionController() const;
+
+    // NOTE: deadline given to every request unless rpc.cancel sets another one, 0 - no deadline
+    void setDefaultTimeout(std::chrono::milliseconds timeout);
+    [[nodiscard]] std::chrono::milliseconds defaultTimeout() const;
+
+    // NOTE: once set, dispatch() checks raw message against limits before parsing it
+    void setLimits(JsonLimits const &limits);
+    [[nodiscard]] JsonLimits limits() const;
+
+    // NOTE: single request at least that large gets its array params parsed in parallel (on thread pool
+    //       if set, otherwise on the global one); 0 - never
+    void setParallelParseThreshold(int bytes);
+    [[nodiscard]] int parallelParseThreshold() const;
+
+    void dispatch(QByteArray const &message, QIODevice *device);
+
+    // single message (element of batch), done is called exactly once
+    // NOTE: session scopes request ids for rpc.cancel, usually the connection
+    void invoke(QJsonValue const &message, Completion done, QObject const *session = nullptr);
+
+protected:
+    [[nodiscard]] virtual int checkRequest(RequestObject const &request, bool notification) const;
+
+private:
+    void dispatchObject(QJsonObject const &jo, QIODevice *device);
+    // NOTE: returns false if message is not a single request with array params
+    [[nodiscard]] bool dispatchLarge(QByteArray const &message, QIODevice *device);
+    void process(QJsonValue const &message, Completion done, QObject const *session, QIODevice *direct);
+    void stream(RequestObject const &request, StreamingHandler const &handler, bool notification, QObject const *session,
+                QIODevice *direct, Completion done);
+    void schedule(QString const &method, AdmissionController::Task run, AdmissionController::Rejection reject);
+    [[nodiscard]] CancellationToken makeToken() const;
+    void cancel(QJsonObject const &params, QObject const *session);
+    void registerToken(QString const &key, CancellationToken const &token);
+    void unregisterToken(QString const &key);
+
+    // coalesced callers share one execution token, it is cancelled only once every caller is,
+    // and its deadline is the latest one of callers not cancelled
+    struct CallGroup
+    {
+        CancellationToken execution;
+        QStringList members;
+    };
+
+    [[nodiscard]] CancellationToken openGroup(QByteArray const &call_key, QString const &key,
+                                              CancellationToken const &token);
+    void joinGroup(QByteArray const &call_key, QString const &key);
+    void closeGroup(QByteArray const &call_key);
+    void updateGroup(CallGroup &group) const;
+
+    QHash<QString, CancellableHandler> m_methods;
+    QHash<QString, AsyncHandler> m_async_methods;
+    QHash<QString, StreamingHandler> m_streaming_methods;
+    bool m_batch_streaming = false;
+    ResultCache *m_cache = nullptr;
+    bool m_coalescing = false;
+    InflightGroup m_inflight;
+    QThreadPool *m_pool = nullptr;
+    AdmissionController *m_admission = nullptr;
+    std::chrono::milliseconds m_default_timeout{ 0 };
+    JsonLimits m_limits;
+    bool m_limited = false;
+    int m_parallel_threshold = 0;
+    QMutex m_tokens_mutex;
+    QHash<QString, CancellationToken> m_tokens;
+    QHash<QByteArray, CallGroup> m_groups;
+    // token key of a coalesced caller -> call key of its group
+    QHash<QString, QByteArray> m_grouped;
+};
+
+} // namespace _2_0
+
+} // namespace qjson
+} // namespace rpc
@@ -0,0 +1,199 @@
+#include <qjsonrpc/qjson-rpc-frame.hpp>
+
+#include <QElapsedTimer>
+#include <QtEndian>
+
+#include <cstring>
+#include <limits>
+
+
+namespace rpc {
+namespace qjson {
+
+inline namespace _2_0 {
+
+namespace {
+
+constexpr quint8 const known_flags = FrameCodec::Compressed | FrameCodec::AcceptsCompressed;
+
+} // namespace
+
+
+double FrameCodec::Stats::ratio() const
+{
+    if (!compressed_bytes)
+        return 0;
+
+    return static_cast<double>(raw_bytes) / static_cast<double>(compressed_bytes);
+}
+
+void FrameCodec::setCompressionEnabled(bool enabled)
+{
+    m_compression = enabled;
+}
+
+bool FrameCodec::isCompressionEnabled() const
+{
+    return m_compression;
+}
+
+void FrameCodec::setCompressionThreshold(int bytes)
+{
+    m_threshold = qMax(bytes, 0);
+}
+
+int FrameCodec::compressionThreshold() const
+{
+    return m_threshold;
+}
+
+void FrameCodec::setCompressionLevel(int level)
+{
+    m_level = qBound(-1, level, 9);
+}
+
+int FrameCodec::compressionLevel() const
+{
+    return m_level;
+}
+
+bool FrameCodec::isPeerAcceptingCompressed() const
+{
+    return m_peer_accepts;
+}
+
+void FrameCodec::setMaxMessageSize(int bytes)
+{
+    m_max_size = qMax(bytes, 0);
+}
+
+int FrameCodec::maxMessageSize() const
+{
+    return m_max_size;
+}
+
+QByteArray FrameCodec::encode(QByteArray const &message)
+{
+    quint8 flags = m_compression ? AcceptsCompressed : 0;
+    QByteArray payload = message;
+
+    if (m_compression && m_peer_accepts && message.size() > m_threshold) {
+        QElapsedTimer timer;
+        timer.start();
+        QByteArray compressed = qCompress(message, m_level);
+        m_stats.compress_nsecs += timer.nsecsElapsed();
+
+        // NOTE: incompressible payload goes as is
+        if (!compressed.isEmpty() && compressed.size() < message.size()) {
+            m_stats.compressed++;
+            m_stats.raw_bytes += static_cast<quint64>(message.size());
+            m_stats.compressed_bytes += static_cast<quint64>(compressed.size());
+            payload = qMove(compressed);
+            flags |= Compressed;
+        }
+    }
+
+    QByteArray frame(frame_header_size + payload.size(), Qt::Uninitialized);
+    qToBigEndian(static_cast<quint32>(payload.size()), frame.data());
+    frame[ 4 ] = static_cast<char>(flags);
+    std::memcpy(frame.data() + frame_header_size, payload.constData(), static_cast<size_t>(payload.size()));
+
+    m_stats.encoded++;
+    return frame;
+}
+
+void FrameCodec::append(QByteArray const &data)
+{
+    int skipped = 0;
+    if (m_skip) {
+        skipped = static_cast<int>(qMin<qint64>(m_skip, data.size()));
+        m_skip -= skipped;
+    }
+
+    if (m_pos && m_pos == m_buffer.size()) {
+        m_buffer.clear();
+        m_pos = 0;
+    }
+    m_buffer.append(data.constData() + skipped, data.size() - skipped);
+}
+
+int FrameCodec::decode(QByteArray &message)
+{
+    message = QByteArray();
+    if (bufferedBytes() < frame_header_size)
+        return 0;
+
+    char const *const header = m_buffer.constData() + m_pos;
+    quint32 const length = qFromBigEndian<quint32>(header);
+    auto const flags = static_cast<quint8>(header[ 4 ]);
+
+    if (m_max_size && length > static_cast<quint32>(m_max_size)) {
+        // NOTE: payload is never larger than its message, so the prefix alone is enough to reject
+        qint64 const buffered = bufferedBytes() - frame_header_size;
+        m_skip = qMax<qint64>(0, length - buffered);
+        m_pos += frame_header_size + static_cast<int>(qMin<qint64>(length, buffered));
+        return errorCode(ParseError::DocumentTooLarge);
+    }
+
+    if (length > static_cast<quint32>(std::numeric_limits<int>::max() - frame_header_size)) {
+        // NOTE: frame boundary is lost, there is nothing to resync on
+        m_buffer.clear();
+        m_pos = 0;
+        return errorCode(TransportError::FrameInvalid);
+    }
+
+    int const frame_size = frame_header_size + static_cast<int>(length);
+    if (bufferedBytes() < frame_size)
+        return 0;
+
+    QByteArray const payload = m_buffer.mid(m_pos + frame_header_size, static_cast<int>(length));
+    m_pos += frame_size;
+
+    // compact once consumed part dominates the buffer
+    if (m_pos > m_buffer.size() / 2) {
+        m_buffer.remove(0, m_pos);
+        m_pos = 0;
+    }
+
+    if (flags & ~known_flags)
+        return errorCode(TransportError::FrameInvalid);
+
+    m_peer_accepts = flags & AcceptsCompressed;
+    m_stats.decoded++;
+
+    if (!(flags & Compressed)) {
+        message = payload;
+        return 0;
+    }
+
+    // qCompress prepends uncompressed size (4 bytes, big endian)
+    if (payload.size() < 4)
+        return errorCode(TransportError::DecompressionFailed);
+    if (m_max_size && qFromBigEndian<quint32>(payload.constData()) > static_cast<quint32>(m_max_size))
+        return errorCode(ParseError::DocumentTooLarge);
+
+    QElapsedTimer timer;
+    timer.start();
+    message = qUncompress(payload);
+    m_stats.decompress_nsecs += timer.nsecsElapsed();
+
+    if (message.isEmpty())
+        return errorCode(TransportError::DecompressionFailed);
+
+    return 0;
+}
+
+int FrameCodec::bufferedBytes() const
+{
+    return m_buffer.size() - m_pos;
+}
+
+FrameCodec::Stats FrameCodec::stats() const
+{
+    return m_stats;
+}
+
+} // namespace _2_0
+
+} // namespace qjson
+} // namespace rpc
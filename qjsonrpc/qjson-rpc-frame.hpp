@@ -0,0 +1,90 @@
+#pragma once
+
+#include <qjsonrpc/qjson-rpc.hpp>
+
+#include <QByteArray>
+
+namespace rpc {
+namespace qjson {
+
+inline namespace _2_0 {
+
+// frame header: payload length (4 bytes, big endian) and flags (1 byte)
+constexpr int const frame_header_size = 5;
+constexpr int const compression_default_threshold = 16 * 1024;
+
+
+/*
+ * Length prefixed framing of one connection with optional zlib (qCompress) compression.
+ * Negotiation: while compression is enabled every outgoing frame carries AcceptsCompressed,
+ * messages above threshold are compressed only after the peer announced the same.
+ **/
+
+class LIBQJSONRPC_EXPORT FrameCodec
+{
+public:
+    enum Flag : quint8
+    {
+        Compressed = 0x01,
+        AcceptsCompressed = 0x02,
+    };
+
+    struct Stats
+    {
+        quint64 encoded = 0;
+        quint64 decoded = 0;
+        quint64 compressed = 0;
+        // payload bytes of compressed frames before and after compression
+        quint64 raw_bytes = 0;
+        quint64 compressed_bytes = 0;
+        qint64 compress_nsecs = 0;
+        qint64 decompress_nsecs = 0;
+
+        // NOTE: raw / compressed, 0 if nothing is compressed yet
+        [[nodiscard]] double ratio() const;
+    };
+
+    void setCompressionEnabled(bool enabled);
+    [[nodiscard]] bool isCompressionEnabled() const;
+
+    void setCompressionThreshold(int bytes);
+    [[nodiscard]] int compressionThreshold() const;
+
+    // NOTE: zlib level, -1 is zlib default
+    void setCompressionLevel(int level);
+    [[nodiscard]] int compressionLevel() const;
+
+    [[nodiscard]] bool isPeerAcceptingCompressed() const;
+
+    // NOTE: 0 - unlimited, checked against length prefix and uncompressed size before allocating,
+    //       oversized frame is discarded as it arrives and decode() reports ParseError::DocumentTooLarge
+    void setMaxMessageSize(int bytes);
+    [[nodiscard]] int maxMessageSize() const;
+
+    [[nodiscard]] QByteArray encode(QByteArray const &message);
+
+    void append(QByteArray const &data);
+    // NOTE: returns 0 and message of the next complete frame (null if there is none yet) or error code,
+    //       invalid frame is skipped so decoding may go on
+    [[nodiscard]] int decode(QByteArray &message);
+    [[nodiscard]] int bufferedBytes() const;
+
+    [[nodiscard]] Stats stats() const;
+
+private:
+    bool m_compression = false;
+    bool m_peer_accepts = false;
+    int m_threshold = compression_default_threshold;
+    int m_level = -1;
+    int m_max_size = 0;
+    // bytes of oversized frame still to discard
+    qint64 m_skip = 0;
+    QByteArray m_buffer;
+    int m_pos = 0;
+    Stats m_stats;
+};
+
+} // namespace _2_0
+
+} // namespace qjson
+} // namespace rpc
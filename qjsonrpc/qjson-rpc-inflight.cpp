@@ -0,0 +1,68 @@
+#include <qjsonrpc/qjson-rpc-inflight.hpp>
+
+#include <qjsonrpc/qjson-rpc-writer.hpp>
+
+#include <QMutexLocker>
+
+
+namespace rpc {
+namespace qjson {
+
+inline namespace _2_0 {
+
+bool InflightGroup::join(RequestObject const &request, Completion done)
+{
+    QByteArray key = callKey(request.method(), request.params());
+
+    QMutexLocker locker(&m_mutex);
+    auto it = m_calls.find(key);
+    if (it == m_calls.end()) {
+        m_calls.insert(qMove(key), QList<Follower>());
+        return true;
+    }
+
+    it->append(Follower{ request.id(), qMove(done) });
+    m_coalesced++;
+    return false;
+}
+
+void InflightGroup::finish(RequestObject const &request, ResponseObject const &response)
+{
+    QByteArray const key = callKey(request.method(), request.params());
+
+    QMutexLocker locker(&m_mutex);
+    QList<Follower> const followers = m_calls.take(key);
+    locker.unlock();
+
+    if (followers.isEmpty())
+        return;
+
+    if (response.contains(latin1string::result)) {
+        // serialized once for every follower
+        QByteArray const result = toJson(response.result());
+        for (Follower const &follower : followers)
+            follower.done(resultResponseJson(follower.id, result));
+        return;
+    }
+
+    ErrorObject const error = response.error();
+    for (Follower const &follower : followers)
+        follower.done(toJson(ResponseObject(error, follower.id)));
+}
+
+int InflightGroup::inflightCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_calls.size();
+}
+
+quint64 InflightGroup::coalescedCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_coalesced;
+}
+
+} // namespace _2_0
+
+} // namespace qjson
+} // namespace rpc
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <qjsonrpc/qjson-rpc.hpp>
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+
+#include <functional>
+
+namespace rpc {
+namespace qjson {
+
+inline namespace _2_0 {
+
+/*
+ * Coalesces identical concurrent calls (same callKey()): the first caller (leader)
+ * executes the call, callers joined meanwhile get leader's result under their own ids.
+ * Thread safe.
+ **/
+
+class LIBQJSONRPC_EXPORT InflightGroup
+{
+public:
+    // NOTE: response is serialized compact json object
+    using Completion = std::function<void(QByteArray const &response)>;
+
+    // NOTE: returns true if caller is the leader and should execute the call, done is not stored then
+    [[nodiscard]] bool join(RequestObject const &request, Completion done);
+
+    // NOTE: should be called by the leader, completes every joined caller
+    void finish(RequestObject const &request, ResponseObject const &response);
+
+    [[nodiscard]] int inflightCount() const;
+    [[nodiscard]] quint64 coalescedCount() const;
+
+private:
+    struct Follower
+    {
+        QJsonValue id;
+        Completion done;
+    };
+
+    mutable QMutex m_mutex;
+    QHash<QByteArray, QList<Follower>> m_calls;
+    quint64 m_coalesced = 0;
+};
+
+} // namespace _2_0
+
+} // namespace qjson
+} // namespace rpc
@@ -0,0 +1,148 @@
+#pragma once
+
+/*
+ * Bodies of small accessors and field checks declared in qjson-rpc.hpp.
+ * Consumers and static builds get them inline through qjson-rpc.hpp; shared library compiles them
+ * in qjson-rpc.cpp only, as exported out-of-line definitions that earlier builds were linked against.
+ **/
+
+#include <qjsonrpc/qjson-rpc.hpp>
+
+#ifndef QJSONRPC_INLINE
+#error "qjson-rpc-inline.hpp is included through qjson-rpc.hpp or by qjson-rpc.cpp only"
+#endif
+
+namespace rpc {
+namespace qjson {
+
+inline namespace _2_0 {
+
+QJSONRPC_INLINE QString JsonRpcObject::jsonrpc() const
+{
+    return value(latin1string::jsonrpc).toString();
+}
+
+QJSONRPC_INLINE QString NotificationObject::method() const
+{
+    return value(latin1string::method).toString();
+}
+
+QJSONRPC_INLINE QJsonValue NotificationObject::params() const
+{
+    return value(latin1string::params);
+}
+
+QJSONRPC_INLINE QJsonValue RequestObject::id() const
+{
+    return value(latin1string::id);
+}
+
+QJSONRPC_INLINE int ErrorObject::code() const
+{
+    return value(latin1string::code).toInt();
+}
+
+QJSONRPC_INLINE QString ErrorObject::message() const
+{
+    return value(latin1string::message).toString();
+}
+
+QJSONRPC_INLINE QJsonValue ErrorObject::data() const
+{
+    return value(latin1string::data);
+}
+
+QJSONRPC_INLINE QJsonValue ResponseObject::id() const
+{
+    return value(latin1string::id);
+}
+
+QJSONRPC_INLINE QJsonValue ResponseObject::result() const
+{
+    return value(latin1string::result);
+}
+
+QJSONRPC_INLINE ErrorObject ResponseObject::error() const
+{
+    return ErrorObject(value(latin1string::error).toObject());
+}
+
+
+QJSONRPC_INLINE bool isIdFieldValid(QJsonObject const &jo)
+{
+    QJsonValue const id_val = jo.value(latin1string::id);
+
+    if (!id_val.isString() && !id_val.isDouble())
+        return false;
+
+    if (id_val.isDouble() && !isInteger(id_val.toDouble()))
+        return false;
+
+    return true;
+}
+
+QJSONRPC_INLINE bool isJsonRpcFieldValid(QJsonObject const &jo)
+{
+    if (!JsonRpcObject::isJsonRpcFieldExists(jo) || !JsonRpcObject::isJsonRpcFieldIsString(jo))
+        return false;
+
+    return true;
+}
+
+QJSONRPC_INLINE bool isNotificationMethodFieldValid(QJsonObject const &jo)
+{
+    QJsonValue const method_val = jo.value(latin1string::method);
+
+    if (!method_val.isString())
+        return false;
+
+    if (method_val.toString().startsWith(latin1string::rpc_dot))
+        return false;
+
+    return true;
+}
+
+QJSONRPC_INLINE bool isNorificationParamsFieldValid(QJsonObject const &jo)
+{
+    QJsonValue const params_val = jo.value(latin1string::params);
+
+    if (!params_val.isObject() && !params_val.isArray())
+        return false;
+
+    return true;
+}
+
+QJSONRPC_INLINE bool isRequestIdFieldValid(QJsonObject const &jo)
+{
+    return isIdFieldValid(jo);
+}
+
+QJSONRPC_INLINE bool isRequestMethodFieldValid(QJsonObject const &jo)
+{
+    return isNotificationMethodFieldValid(jo);
+}
+
+QJSONRPC_INLINE bool isRequestParamsFieldValid(QJsonObject const &jo)
+{
+    return isNorificationParamsFieldValid(jo);
+}
+
+QJSONRPC_INLINE bool isResponseIdFieldValid(QJsonObject const &jo)
+{
+    return isIdFieldValid(jo);
+}
+
+QJSONRPC_INLINE bool isResponseResultFieldValid(QJsonObject const &jo)
+{
+    QJsonValue const res_val = jo.value(latin1string::result);
+
+    if (res_val.isNull())
+        return false;
+
+    return true;
+}
+
+} // namespace _2_0
+
+} // namespace qjson
+} // namespace rpc
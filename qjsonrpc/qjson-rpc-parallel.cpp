@@ -0,0 +1,211 @@
+#include <qjsonrpc/qjson-rpc-parallel.hpp>
+
+#include <qjsonrpc/qjson-rpc-scanner.hpp>
+
+#include <QAtomicInt>
+#include <QJsonDocument>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QSharedPointer>
+#include <QVector>
+#include <QWaitCondition>
+
+
+namespace rpc {
+namespace qjson {
+
+inline namespace _2_0 {
+
+namespace {
+
+// NOTE: elements with separators between them, brackets excluded
+struct Chunk
+{
+    int begin;
+    int end;
+};
+
+[[nodiscard]] int splitArray(QByteArray const &raw, int begin, int end, int chunk_bytes, QVector<Chunk> &chunks)
+{
+    QByteArray const view = QByteArray::fromRawData(raw.constData() + begin, end - begin);
+    JsonScanner scanner(view);
+    if (!scanner.consume('['))
+        return errorCode(ParseError::IllegalValue);
+    if (scanner.consume(']'))
+        return scanner.expectEnd();
+
+    (void)scanner.peek();
+    int chunk_begin = scanner.offset();
+    for (;;) {
+        if (int err = scanner.skipValue())
+            return err;
+
+        if (scanner.offset() - chunk_begin >= chunk_bytes) {
+            chunks.append(Chunk{ begin + chunk_begin, begin + scanner.offset() });
+            chunk_begin = -1;
+        }
+
+        if (!scanner.consume(','))
+            break;
+
+        if (chunk_begin < 0) {
+            (void)scanner.peek();
+            chunk_begin = scanner.offset();
+        }
+    }
+    if (chunk_begin >= 0)
+        chunks.append(Chunk{ begin + chunk_begin, begin + scanner.offset() });
+
+    if (!scanner.consume(']'))
+        return errorCode(scanner.atEnd() ? ParseError::UnterminatedArray : ParseError::MissingValueSeparator);
+
+    return scanner.expectEnd();
+}
+
+class ParseState
+{
+public:
+    ParseState(QByteArray raw, QVector<Chunk> chunks)
+        : m_raw(qMove(raw)), m_chunks(qMove(chunks)), m_results(m_chunks.size()), m_errors(m_chunks.size()),
+          m_done(m_chunks.size())
+    {
+    }
+
+    [[nodiscard]] int count() const { return m_chunks.size(); }
+    [[nodiscard]] int claimed() const { return m_next.loadAcquire(); }
+
+    // NOTE: returns false once every chunk is claimed
+    bool parseNext()
+    {
+        int const i = m_next.fetchAndAddOrdered(1);
+        if (i >= m_chunks.size())
+            return false;
+
+        Chunk const chunk = m_chunks.at(i);
+        QByteArray wrapped;
+        wrapped.reserve(chunk.end - chunk.begin + 2);
+        wrapped.append('[');
+        wrapped.append(m_raw.constData() + chunk.begin, chunk.end - chunk.begin);
+        wrapped.append(']');
+
+        QJsonParseError je;
+        QJsonDocument const doc = QJsonDocument::fromJson(wrapped, &je);
+
+        QMutexLocker locker(&m_mutex);
+        if (je.error != QJsonParseError::NoError)
+            m_errors[ i ] = errorCode(je.error);
+        else
+            m_results[ i ] = doc.array();
+        m_done[ i ] = true;
+        m_condition.wakeAll();
+        return true;
+    }
+
+    // NOTE: returns chunk's error code, chunk is moved out on success
+    [[nodiscard]] int take(int i, QJsonArray &chunk)
+    {
+        QMutexLocker locker(&m_mutex);
+        while (!m_done.at(i))
+            m_condition.wait(&m_mutex);
+
+        chunk = m_results.at(i);
+        m_results[ i ] = QJsonArray();
+        return m_errors.at(i);
+    }
+
+    // NOTE: workers still running find nothing left
+    void abandon() { m_next.storeRelease(m_chunks.size()); }
+
+private:
+    QByteArray const m_raw;
+    QVector<Chunk> const m_chunks;
+    QAtomicInt m_next{ 0 };
+    QMutex m_mutex;
+    QWaitCondition m_condition;
+    QVector<QJsonArray> m_results;
+    QVector<int> m_errors;
+    QVector<bool> m_done;
+};
+
+class ChunkWorker : public QRunnable
+{
+public:
+    explicit ChunkWorker(QSharedPointer<ParseState> state) : m_state(qMove(state)) {}
+
+    void run() override
+    {
+        while (m_state->parseNext()) {}
+    }
+
+private:
+    QSharedPointer<ParseState> m_state;
+};
+
+} // namespace
+
+
+int parseArray(QByteArray const &raw, int begin, int end, ArrayChunkSink const &sink, QThreadPool *pool)
+{
+    Q_ASSERT(0 <= begin && begin <= end && end <= raw.size());
+    if (!pool)
+        pool = QThreadPool::globalInstance();
+
+    // several chunks per thread even out elements of uneven size
+    int const threads = qMax(1, pool->maxThreadCount());
+    int const chunk_bytes = qMax(parallel_parse_min_chunk_bytes, (end - begin) / (4 * threads));
+
+    QVector<Chunk> chunks;
+    if (int err = splitArray(raw, begin, end, chunk_bytes, chunks))
+        return err;
+
+    auto const state = QSharedPointer<ParseState>::create(raw, qMove(chunks));
+    for (int i = 0; i < qMin(state->count() - 1, threads); ++i)
+        pool->start(new ChunkWorker(state));
+
+    for (int i = 0; i < state->count(); ++i) {
+        // parse next chunks instead of idling while the awaited one is unclaimed
+        while (state->claimed() <= i && state->parseNext()) {}
+
+        QJsonArray chunk;
+        if (int err = state->take(i, chunk)) {
+            state->abandon();
+            return err;
+        }
+        sink(chunk);
+    }
+    return 0;
+}
+
+int parseArray(QByteArray const &raw, int begin, int end, QJsonArray &array, QThreadPool *pool)
+{
+    array = QJsonArray();
+    if (end - begin < parallel_parse_min_bytes) {
+        QJsonParseError je;
+        QJsonDocument const doc = QJsonDocument::fromJson(raw.mid(begin, end - begin), &je);
+        if (je.error != QJsonParseError::NoError)
+            return errorCode(je.error);
+        if (!doc.isArray())
+            return errorCode(ParseError::IllegalValue);
+
+        array = doc.array();
+        return 0;
+    }
+
+    return parseArray(
+        raw, begin, end,
+        [&array](QJsonArray const &chunk) {
+            if (array.isEmpty()) {
+                array = chunk;
+                return;
+            }
+            for (QJsonValue const &element : chunk)
+                array.append(element);
+        },
+        pool);
+}
+
+} // namespace _2_0
+
+} // namespace qjson
+} // namespace rpc
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <qjsonrpc/qjson-rpc.hpp>
+
+#include <QByteArray>
+#include <QJsonArray>
+#include <QThreadPool>
+
+#include <functional>
+
+namespace rpc {
+namespace qjson {
+
+inline namespace _2_0 {
+
+// below that plain QJsonDocument::fromJson() is about as fast
+constexpr int const parallel_parse_min_bytes = 1024 * 1024;
+constexpr int const parallel_parse_min_chunk_bytes = 64 * 1024;
+
+
+/*
+ * Large array parsing: element boundaries are found structurally (JsonScanner),
+ * then chunks of elements are parsed on a thread pool. Calling thread parses chunks too,
+ * so it is fine to call from a pool's thread. Returns 0 or errorCode(ParseError).
+ * [begin, end) of raw should be a json array, e.g. EnvelopePeek params_begin/params_end.
+ **/
+
+using ArrayChunkSink = std::function<void(QJsonArray const &chunk)>;
+
+// NOTE: chunks come in order in the calling thread, nothing is delivered after an error; null pool - global one
+[[nodiscard]] LIBQJSONRPC_EXPORT int parseArray(QByteArray const &raw, int begin, int end, ArrayChunkSink const &sink,
+                                                QThreadPool *pool = nullptr);
+
+[[nodiscard]] LIBQJSONRPC_EXPORT int parseArray(QByteArray const &raw, int begin, int end, QJsonArray &array,
+                                                QThreadPool *pool = nullptr);
+
+} // namespace _2_0
+
+} // namespace qjson
+} // namespace rpc
@@ -0,0 +1,150 @@
+#include <qjsonrpc/qjson-rpc-peek.hpp>
+
+#include <qjsonrpc/qjson-rpc-scanner.hpp>
+
+#include <cmath>
+
+
+namespace rpc {
+namespace qjson {
+
+inline namespace _2_0 {
+
+namespace {
+
+struct Field
+{
+    int begin = -1;
+    int end = -1;
+    char lead = '\0';
+
+    [[nodiscard]] bool exists() const { return begin >= 0; }
+    [[nodiscard]] bool isString() const { return lead == '"'; }
+};
+
+[[nodiscard]] QByteArray view(QByteArray const &raw, int begin, int end)
+{
+    return QByteArray::fromRawData(raw.constData() + begin, end - begin);
+}
+
+[[nodiscard]] QLatin1String latin1View(QByteArray const &raw, int begin, int end)
+{
+    return QLatin1String(raw.constData() + begin, end - begin);
+}
+
+} // namespace
+
+
+bool EnvelopePeek::isNotification() const
+{
+    return id.isNull();
+}
+
+bool EnvelopePeek::hasParams() const
+{
+    return params_begin >= 0;
+}
+
+
+int peekEnvelope(QByteArray const &raw, EnvelopePeek &peek, JsonLimits const &limits)
+{
+    peek = EnvelopePeek();
+    if (limits.max_bytes && raw.size() > limits.max_bytes)
+        return errorCode(ParseError::DocumentTooLarge);
+
+    JsonScanner scanner(raw, limits);
+
+    if (scanner.peek() == '[') {
+        peek.batch = true;
+        return 0;
+    }
+
+    if (!scanner.consume('{'))
+        return errorCode(ParseError::MissingObject);
+
+    Field jsonrpc, id, method, params;
+    int extra_members = 0;
+    if (!scanner.consume('}')) {
+        do {
+            int key_begin = -1;
+            int key_end = -1;
+            if (int err = scanner.scanString(key_begin, key_end))
+                return err;
+
+            if (!scanner.consume(':'))
+                return errorCode(ParseError::MissingNameSeparator);
+
+            Field value;
+            value.lead = scanner.peek();
+            value.begin = scanner.offset();
+            if (int err = scanner.skipValue())
+                return err;
+            value.end = scanner.offset();
+
+            QLatin1String const key = latin1View(raw, key_begin, key_end);
+            Field *field = nullptr;
+            if (key == latin1string::jsonrpc)
+                field = &jsonrpc;
+            else if (key == latin1string::id)
+                field = &id;
+            else if (key == latin1string::method)
+                field = &method;
+            else if (key == latin1string::params)
+                field = &params;
+
+            if (!field || field->exists())
+                ++extra_members;
+            else
+                *field = value;
+        } while (scanner.consume(','));
+
+        if (!scanner.consume('}'))
+            return errorCode(scanner.atEnd() ? ParseError::UnterminatedObject : ParseError::MissingValueSeparator);
+    }
+
+    if (int err = scanner.expectEnd())
+        return err;
+
+    int const invalid = errorCode(id.exists() ? ServerError::RequestInvalid : ServerError::NotificationInvalid);
+
+    if (!jsonrpc.isString() || !method.isString())
+        return invalid;
+
+    // strip quotes
+    QLatin1String const version = latin1View(raw, jsonrpc.begin + 1, jsonrpc.end - 1);
+    if (version != latin1string::_2_0)
+        return errorCode(ServerError::RpcVersionUnsupported);
+
+    QLatin1String const method_name = latin1View(raw, method.begin + 1, method.end - 1);
+    if (method_name.startsWith(latin1string::rpc_dot))
+        return errorCode(ServerError::MethodReserved);
+
+    if (id.exists()) {
+        if (!id.isString() && id.lead != '-' && !('0' <= id.lead && id.lead <= '9'))
+            return errorCode(ServerError::RequestInvalid);
+
+        if (!id.isString()) {
+            double const d = view(raw, id.begin, id.end).toDouble();
+            if (!qIsNull(d - std::trunc(d)))
+                return errorCode(ServerError::RequestInvalid);
+        }
+    }
+
+    if (params.exists() && params.lead != '{' && params.lead != '[')
+        return errorCode(ServerError::ParametersInvalid);
+
+    peek.jsonrpc = view(raw, jsonrpc.begin + 1, jsonrpc.end - 1);
+    peek.method = view(raw, method.begin + 1, method.end - 1);
+    if (id.exists())
+        peek.id = view(raw, id.begin, id.end);
+    peek.params_begin = params.begin;
+    peek.params_end = params.end;
+    peek.extra_members = extra_members;
+
+    return 0;
+}
+
+} // namespace _2_0
+
+} // namespace qjson
+} // namespace rpc
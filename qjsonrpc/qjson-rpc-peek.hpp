@@ -0,0 +1,47 @@
+#pragma once
+
+#include <qjsonrpc/qjson-rpc-scanner.hpp>
+#include <qjsonrpc/qjson-rpc.hpp>
+
+#include <QByteArray>
+
+namespace rpc {
+namespace qjson {
+
+inline namespace _2_0 {
+
+/*
+ * Top level fields of a raw message, found without a full parse.
+ * Byte arrays are views (QByteArray::fromRawData) into the scanned buffer:
+ * they are valid while that buffer is alive and unmodified.
+ **/
+
+struct LIBQJSONRPC_EXPORT EnvelopePeek
+{
+    QByteArray jsonrpc; // string content, escape sequences are not decoded
+    QByteArray id;      // raw json token, null for notifications
+    QByteArray method;  // string content, escape sequences are not decoded
+
+    // [params_begin, params_end) - raw json value, -1 if params are absent
+    int params_begin = -1;
+    int params_end = -1;
+
+    // members besides the four above, repeated ones included; message is not a valid request if any
+    int extra_members = 0;
+
+    // top level is an array, fields are not filled
+    bool batch = false;
+
+    [[nodiscard]] bool isNotification() const;
+    [[nodiscard]] bool hasParams() const;
+};
+
+
+// NOTE: nested values are skipped by structure alone, so returned 0 does not guarantee fromJson() success
+[[nodiscard]] LIBQJSONRPC_EXPORT int peekEnvelope(QByteArray const &raw, EnvelopePeek &peek,
+                                                   JsonLimits const &limits = JsonLimits());
+
+} // namespace _2_0
+
+} // namespace qjson
+} // namespace rpc
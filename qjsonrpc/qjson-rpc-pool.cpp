@@ -0,0 +1,322 @@
+#include <qjsonrpc/qjson-rpc-pool.hpp>
+
+#include <qjsonrpc/qjson-rpc-writer.hpp>
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QList>
+
+
+namespace rpc {
+namespace qjson {
+
+inline namespace _2_0 {
+
+ConnectionPool::ConnectionPool(QObject *parent) : QObject(parent)
+{
+    connect(&m_health, &QTimer::timeout, this, &ConnectionPool::onHealthCheck);
+    connect(&m_expiry, &QTimer::timeout, this, &ConnectionPool::onExpiry);
+}
+
+void ConnectionPool::addEndpoint(Connector connector, int connections)
+{
+    m_endpoints.append(qMove(connector));
+    for (int i = 0; i < connections; ++i) {
+        auto connection = QSharedPointer<Connection>::create();
+        connection->endpoint = m_endpoints.size() - 1;
+        m_connections.append(connection);
+        open(m_connections.size() - 1);
+    }
+}
+
+void ConnectionPool::setReconnectBackoff(std::chrono::milliseconds initial, std::chrono::milliseconds max)
+{
+    Q_ASSERT(initial <= max);
+    m_initial_backoff = initial;
+    m_max_backoff = max;
+}
+
+void ConnectionPool::setHealthCheck(QString method, std::chrono::milliseconds interval)
+{
+    m_probe_method = qMove(method);
+    if (interval.count() > 0)
+        m_health.start(static_cast<int>(interval.count()));
+    else
+        m_health.stop();
+}
+
+void ConnectionPool::setCompressionEnabled(bool enabled)
+{
+    m_compression = enabled;
+}
+
+void ConnectionPool::setCallTimeout(std::chrono::milliseconds timeout)
+{
+    m_call_timeout = timeout;
+    m_expiry.stop();
+}
+
+std::chrono::milliseconds ConnectionPool::callTimeout() const
+{
+    return m_call_timeout;
+}
+
+void ConnectionPool::call(RequestObject const &request, Callback callback)
+{
+    int const index = pick();
+    if (index < 0) {
+        callback(ResponseObject(ErrorObject(errorCode(TransportError::NotConnected)), request.id()));
+        return;
+    }
+
+    qint64 const id = m_next_id++;
+    RequestObject wire = request;
+    wire[ latin1string::id ] = id;
+
+    Connection &connection = *m_connections[ index ];
+    QDeadlineTimer const deadline = m_call_timeout.count() ? QDeadlineTimer(m_call_timeout.count())
+                                                           : QDeadlineTimer(QDeadlineTimer::Forever);
+    m_pending.insert(id, Pending{ qMove(callback), request.id(), index, deadline });
+    connection.outstanding++;
+    send(connection, wire);
+
+    // NOTE: expired calls are swept several times per timeout, so they fail at most a quarter late
+    if (m_call_timeout.count() && !m_expiry.isActive())
+        m_expiry.start(static_cast<int>(qBound<qint64>(10, m_call_timeout.count() / 4, 1000)));
+}
+
+int ConnectionPool::notify(NotificationObject const &notification)
+{
+    int const index = pick();
+    if (index < 0)
+        return errorCode(TransportError::NotConnected);
+
+    send(*m_connections[ index ], notification);
+    return 0;
+}
+
+int ConnectionPool::connectionCount() const
+{
+    return m_connections.size();
+}
+
+int ConnectionPool::availableCount() const
+{
+    int count = 0;
+    for (auto const &connection : m_connections) {
+        if (connection->device && connection->device->isOpen())
+            count++;
+    }
+    return count;
+}
+
+int ConnectionPool::outstandingCount() const
+{
+    return m_pending.size();
+}
+
+void ConnectionPool::open(int index)
+{
+    Connection &connection = *m_connections[ index ];
+    connection.reconnecting = false;
+    if (connection.device)
+        return;
+
+    QIODevice *const device = m_endpoints[ connection.endpoint ]();
+    if (!device || !device->isOpen()) {
+        delete device;
+        scheduleReconnect(index);
+        return;
+    }
+
+    device->setParent(this);
+    connection.device = device;
+    connection.codec = FrameCodec();
+    connection.codec.setCompressionEnabled(m_compression);
+    connection.outstanding = 0;
+    connection.probe = 0;
+
+    connect(device, &QIODevice::readyRead, this, [this, index] { onReadyRead(index); });
+    // NOTE: queued, device should not be deleted while it is closing
+    connect(device, &QIODevice::aboutToClose, this, [this, index] { lose(index); }, Qt::QueuedConnection);
+
+    emit connectionOpened(index);
+
+    if (device->bytesAvailable())
+        onReadyRead(index);
+}
+
+void ConnectionPool::lose(int index)
+{
+    Connection &connection = *m_connections[ index ];
+    if (!connection.device)
+        return;
+
+    QIODevice *const device = connection.device;
+    connection.device = nullptr;
+    connection.outstanding = 0;
+    connection.probe = 0;
+    device->disconnect(this);
+    device->deleteLater();
+
+    // callbacks may call again, so pending requests are detached first
+    QList<Pending> failed;
+    for (auto it = m_pending.begin(); it != m_pending.end();) {
+        if (it->connection == index) {
+            failed.append(qMove(*it));
+            it = m_pending.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    emit connectionLost(index);
+    scheduleReconnect(index);
+
+    for (Pending const &pending : qAsConst(failed))
+        pending.callback(ResponseObject(ErrorObject(errorCode(TransportError::ConnectionLost)), pending.id));
+}
+
+void ConnectionPool::scheduleReconnect(int index)
+{
+    Connection &connection = *m_connections[ index ];
+    if (connection.reconnecting)
+        return;
+
+    connection.reconnecting = true;
+    connection.backoff = connection.backoff.count() ? qMin(2 * connection.backoff, m_max_backoff) : m_initial_backoff;
+    QTimer::singleShot(connection.backoff, this, [this, index] { open(index); });
+}
+
+void ConnectionPool::onReadyRead(int index)
+{
+    Connection &connection = *m_connections[ index ];
+    if (!connection.device)
+        return;
+
+    connection.codec.append(connection.device->readAll());
+    for (;;) {
+        QByteArray message;
+        if (int err = connection.codec.decode(message)) {
+            qCDebug(rpcQJson2_0()).noquote() << QObject::tr("connection %1: %2").arg(index).arg(errorString(err));
+            // NOTE: frame boundary is lost
+            if (err == errorCode(TransportError::FrameInvalid) && !connection.codec.bufferedBytes()) {
+                lose(index);
+                return;
+            }
+            continue;
+        }
+        if (message.isNull())
+            return;
+
+        QJsonDocument const doc = QJsonDocument::fromJson(message);
+        if (doc.isObject()) {
+            route(index, doc.object());
+        } else {
+            for (QJsonValue const &response : doc.array()) {
+                if (response.isObject())
+                    route(index, response.toObject());
+            }
+        }
+
+        // NOTE: callbacks may lose the connection
+        if (!connection.device)
+            return;
+    }
+}
+
+void ConnectionPool::onHealthCheck()
+{
+    for (int i = 0; i < m_connections.size(); ++i) {
+        Connection &connection = *m_connections[ i ];
+        if (!connection.device)
+            continue;
+
+        if (connection.probe) {
+            qCDebug(rpcQJson2_0()).noquote() << QObject::tr("connection %1: health check is unanswered").arg(i);
+            connection.device->close();
+            continue;
+        }
+
+        connection.probe = m_next_id++;
+        send(connection, RequestObject(m_probe_method, connection.probe));
+    }
+}
+
+void ConnectionPool::onExpiry()
+{
+    // callbacks may call again, so expired requests are detached first
+    QList<Pending> expired;
+    for (auto it = m_pending.begin(); it != m_pending.end();) {
+        if (!it->deadline.hasExpired()) {
+            ++it;
+            continue;
+        }
+        if (m_connections[ it->connection ]->outstanding > 0)
+            m_connections[ it->connection ]->outstanding--;
+        expired.append(qMove(*it));
+        it = m_pending.erase(it);
+    }
+
+    if (m_pending.isEmpty())
+        m_expiry.stop();
+
+    for (Pending const &pending : qAsConst(expired))
+        pending.callback(ResponseObject(ErrorObject(errorCode(TransportError::ResponseTimeout)), pending.id));
+}
+
+void ConnectionPool::route(int index, QJsonObject const &jo)
+{
+    if (!isResponseObject(jo)) {
+        qCDebug(rpcQJson2_0()).noquote() << QObject::tr("connection %1: response is invalid").arg(index);
+        return;
+    }
+
+    Connection &connection = *m_connections[ index ];
+    connection.backoff = std::chrono::milliseconds(0);
+
+    auto const id = static_cast<qint64>(jo.value(latin1string::id).toDouble());
+    // NOTE: error without id reads as 0, never a probe id
+    if (connection.probe && id == connection.probe) {
+        connection.probe = 0;
+        return;
+    }
+
+    auto const it = m_pending.find(id);
+    if (it == m_pending.end()) {
+        qCDebug(rpcQJson2_0()).noquote() << QObject::tr("connection %1: response to unknown id").arg(index);
+        return;
+    }
+
+    Pending const pending = it.value();
+    m_pending.erase(it);
+    if (m_connections[ pending.connection ]->outstanding > 0)
+        m_connections[ pending.connection ]->outstanding--;
+
+    ResponseObject response = JsonRpcObject(jo);
+    response[ latin1string::id ] = pending.id;
+    pending.callback(response);
+}
+
+int ConnectionPool::pick() const
+{
+    int best = -1;
+    for (int i = 0; i < m_connections.size(); ++i) {
+        Connection const &connection = *m_connections[ i ];
+        if (!connection.device || !connection.device->isOpen())
+            continue;
+        if (best < 0 || connection.outstanding < m_connections[ best ]->outstanding)
+            best = i;
+    }
+    return best;
+}
+
+void ConnectionPool::send(Connection &connection, QJsonObject const &message)
+{
+    connection.device->write(connection.codec.encode(toJson(message)));
+}
+
+} // namespace _2_0
+
+} // namespace qjson
+} // namespace rpc
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <qjsonrpc/qjson-rpc-frame.hpp>
+#include <qjsonrpc/qjson-rpc.hpp>
+
+#include <QByteArray>
+#include <QDeadlineTimer>
+#include <QHash>
+#include <QIODevice>
+#include <QObject>
+#include <QPointer>
+#include <QSharedPointer>
+#include <QTimer>
+#include <QVector>
+
+#include <chrono>
+#include <functional>
+
+namespace rpc {
+namespace qjson {
+
+inline namespace _2_0 {
+
+/*
+ * Client side pool of framed (FrameCodec) connections to one or more endpoints.
+ * Every message goes to the available connection with the fewest outstanding requests.
+ * Lost connections fail their outstanding requests with TransportError::ConnectionLost
+ * and are reopened with exponential backoff.
+ **/
+
+class LIBQJSONRPC_EXPORT ConnectionPool : public QObject
+{
+    Q_OBJECT
+
+public:
+    // NOTE: returns open (or opening, as sockets are) device or nullptr, pool takes ownership;
+    //       device closing is taken as connection loss
+    using Connector = std::function<QIODevice *()>;
+    using Callback = std::function<void(ResponseObject const &response)>;
+
+    explicit ConnectionPool(QObject *parent = nullptr);
+
+    void addEndpoint(Connector connector, int connections = 1);
+
+    void setReconnectBackoff(std::chrono::milliseconds initial, std::chrono::milliseconds max);
+
+    // NOTE: probe request goes to every connection each interval, one unanswered till the next tick
+    //       means connection is lost (any response, error too, is an answer); 0 - no health checks
+    void setHealthCheck(QString method, std::chrono::milliseconds interval);
+
+    // NOTE: applies to connections opened afterwards
+    void setCompressionEnabled(bool enabled);
+
+    // NOTE: call unanswered that long is failed with TransportError::ResponseTimeout and its late response
+    //       is dropped, e.g. the one lost in an error without id; 0 - wait as long as connection lives
+    void setCallTimeout(std::chrono::milliseconds timeout);
+    [[nodiscard]] std::chrono::milliseconds callTimeout() const;
+
+    // NOTE: request id is replaced by pool unique one on the wire, response brings the original back
+    void call(RequestObject const &request, Callback callback);
+    // returns 0 or error code
+    [[nodiscard]] int notify(NotificationObject const &notification);
+
+    [[nodiscard]] int connectionCount() const;
+    [[nodiscard]] int availableCount() const;
+    [[nodiscard]] int outstandingCount() const;
+
+signals:
+    void connectionOpened(int index);
+    void connectionLost(int index);
+
+private:
+    struct Connection
+    {
+        int endpoint = -1;
+        QPointer<QIODevice> device;
+        FrameCodec codec;
+        int outstanding = 0;
+        // pool id of unanswered probe, 0 - none
+        qint64 probe = 0;
+        std::chrono::milliseconds backoff{ 0 };
+        bool reconnecting = false;
+    };
+
+    struct Pending
+    {
+        Callback callback;
+        QJsonValue id;
+        int connection;
+        QDeadlineTimer deadline;
+    };
+
+    void open(int index);
+    void lose(int index);
+    void scheduleReconnect(int index);
+    void onReadyRead(int index);
+    void onHealthCheck();
+    void onExpiry();
+    void route(int index, QJsonObject const &jo);
+    [[nodiscard]] int pick() const;
+    void send(Connection &connection, QJsonObject const &message);
+
+    QVector<Connector> m_endpoints;
+    QVector<QSharedPointer<Connection>> m_connections;
+    QHash<qint64, Pending> m_pending;
+    qint64 m_next_id = 1;
+    std::chrono::milliseconds m_initial_backoff{ 100 };
+    std::chrono::milliseconds m_max_backoff{ 10'000 };
+    QTimer m_health;
+    std::chrono::milliseconds m_call_timeout{ 30'000 };
+    QTimer m_expiry;
+    QString m_probe_method;
+    bool m_compression = false;
+};
+
+} // namespace _2_0
+
+} // namespace qjson
+} // namespace rpc
@@ -0,0 +1,60 @@
+#include <qjsonrpc/qjson-rpc-promise.hpp>
+
+
+namespace rpc {
+namespace qjson {
+
+inline namespace _2_0 {
+
+ResponsePromise::State::~State()
+{
+    if (settled.testAndSetOrdered(0, 1)) {
+        qCDebug(rpcQJson2_0()).noquote() << QObject::tr("promise is dropped unsettled");
+        completion(ResponseObject(ErrorObject(errorCode(ServerError::Internal)), id));
+    }
+}
+
+ResponsePromise::ResponsePromise(QJsonValue id, Completion completion) : m_state(QSharedPointer<State>::create())
+{
+    m_state->id = qMove(id);
+    m_state->completion = qMove(completion);
+}
+
+void ResponsePromise::resolve(QJsonValue result)
+{
+    // NOTE: promise of notification has no id to respond with, its response is dropped anyway
+    if (m_state->id.isUndefined() || m_state->id.isNull()) {
+        respond(ResponseObject(JsonRpcObject(latin1string::_2_0)));
+        return;
+    }
+
+    respond(ResponseObject(m_state->id, qMove(result)));
+}
+
+void ResponsePromise::reject(ErrorObject error)
+{
+    respond(ResponseObject(qMove(error), m_state->id));
+}
+
+void ResponsePromise::respond(ResponseObject const &response)
+{
+    if (!m_state->settled.testAndSetOrdered(0, 1))
+        return;
+
+    m_state->completion(response);
+}
+
+bool ResponsePromise::isSettled() const
+{
+    return m_state->settled.loadAcquire();
+}
+
+QJsonValue ResponsePromise::id() const
+{
+    return m_state->id;
+}
+
+} // namespace _2_0
+
+} // namespace qjson
+} // namespace rpc
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <qjsonrpc/qjson-rpc.hpp>
+
+#include <QAtomicInt>
+#include <QSharedPointer>
+
+#include <functional>
+
+namespace rpc {
+namespace qjson {
+
+inline namespace _2_0 {
+
+/*
+ * Pending response of one request, settled once from any thread: the first resolve(),
+ * reject() or respond() wins, the rest are ignored. Copies share the state; if the last
+ * copy goes away unsettled, request is answered with ServerError::Internal.
+ **/
+
+class LIBQJSONRPC_EXPORT ResponsePromise
+{
+public:
+    using Completion = std::function<void(ResponseObject const &response)>;
+
+    ResponsePromise(QJsonValue id, Completion completion);
+
+    void resolve(QJsonValue result);
+    void reject(ErrorObject error);
+    void respond(ResponseObject const &response);
+
+    [[nodiscard]] bool isSettled() const;
+    [[nodiscard]] QJsonValue id() const;
+
+private:
+    struct State
+    {
+        ~State();
+
+        QJsonValue id;
+        Completion completion;
+        QAtomicInt settled{ 0 };
+    };
+
+    QSharedPointer<State> m_state;
+};
+
+} // namespace _2_0
+
+} // namespace qjson
+} // namespace rpc
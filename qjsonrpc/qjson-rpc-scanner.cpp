@@ -0,0 +1,241 @@
+#include <qjsonrpc/qjson-rpc-scanner.hpp>
+
+#include <QVarLengthArray>
+
+#include <cstring>
+
+
+[[nodiscard]] static bool isWhitespace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+[[nodiscard]] static bool isDigit(char c)
+{
+    return '0' <= c && c <= '9';
+}
+
+
+namespace rpc {
+namespace qjson {
+
+inline namespace _2_0 {
+
+JsonScanner::JsonScanner(QByteArray const &raw, JsonLimits const &limits)
+    : m_begin(raw.constData()), m_pos(m_begin), m_end(m_begin + raw.size()), m_limits(limits)
+{
+}
+
+int JsonScanner::offset() const
+{
+    return static_cast<int>(m_pos - m_begin);
+}
+
+bool JsonScanner::atEnd() const
+{
+    return m_pos == m_end;
+}
+
+char JsonScanner::peek()
+{
+    while (m_pos != m_end && isWhitespace(*m_pos))
+        ++m_pos;
+    return m_pos == m_end ? '\0' : *m_pos;
+}
+
+bool JsonScanner::consume(char c)
+{
+    if (peek() != c)
+        return false;
+
+    ++m_pos;
+    return true;
+}
+
+int JsonScanner::scanString(int &begin, int &end, bool *escaped)
+{
+    if (peek() != '"')
+        return errorCode(ParseError::IllegalValue);
+
+    char const *const start = m_pos + 1;
+    if (int err = skipString())
+        return err;
+
+    begin = static_cast<int>(start - m_begin);
+    end = offset() - 1;
+    if (escaped)
+        *escaped = std::memchr(start, '\\', static_cast<size_t>(end - begin)) != nullptr;
+
+    return 0;
+}
+
+int JsonScanner::skipValue()
+{
+    switch (peek()) {
+    case '\0': return errorCode(ParseError::IllegalValue);
+    case '"': return skipString();
+    case '{':
+    case '[': return skipContainer();
+    case 't':
+    case 'f':
+    case 'n': return skipLiteral();
+    default: return skipNumber();
+    }
+}
+
+int JsonScanner::expectEnd()
+{
+    if (peek() != '\0' || !atEnd())
+        return errorCode(ParseError::GarbageAtEnd);
+
+    return 0;
+}
+
+int JsonScanner::skipString()
+{
+    Q_ASSERT(*m_pos == '"');
+    char const *const start = m_pos;
+    for (++m_pos; m_pos != m_end; ++m_pos) {
+        switch (*m_pos) {
+        case '"':
+            if (m_limits.max_string_length && m_pos - start - 1 > m_limits.max_string_length)
+                return errorCode(ParseError::DocumentTooLarge);
+            ++m_pos;
+            return 0;
+        case '\\':
+            if (++m_pos == m_end)
+                return errorCode(ParseError::UnterminatedString);
+            if (!std::memchr("\"\\/bfnrtu", *m_pos, 9))
+                return errorCode(ParseError::IllegalEscapeSequence);
+            break;
+        default: break;
+        }
+    }
+    return errorCode(ParseError::UnterminatedString);
+}
+
+int JsonScanner::skipNumber()
+{
+    char const *const start = m_pos;
+    if (*m_pos == '-')
+        ++m_pos;
+    if (m_pos == m_end || !isDigit(*m_pos))
+        return errorCode(start == m_pos ? ParseError::IllegalValue : ParseError::IllegalNumber);
+
+    while (m_pos != m_end && (isDigit(*m_pos) || *m_pos == '.' || *m_pos == 'e' || *m_pos == 'E' ||
+                              *m_pos == '+' || *m_pos == '-'))
+        ++m_pos;
+
+    return 0;
+}
+
+int JsonScanner::skipLiteral()
+{
+    static constexpr char const *const literals[] = { "true", "false", "null" };
+
+    for (char const *literal : literals) {
+        auto const size = std::strlen(literal);
+        if (static_cast<size_t>(m_end - m_pos) >= size && !std::memcmp(m_pos, literal, size)) {
+            m_pos += size;
+            return 0;
+        }
+    }
+    return errorCode(ParseError::IllegalValue);
+}
+
+int JsonScanner::skipContainer()
+{
+    // closing brackets and element separators count of the open containers
+    QVarLengthArray<char, 64> closers;
+    QVarLengthArray<int, 64> separators;
+
+    for (;;) {
+        switch (char const c = peek()) {
+        case '\0':
+            if (!atEnd())
+                return errorCode(ParseError::IllegalValue);
+            return errorCode(closers.last() == '}' ? ParseError::UnterminatedObject : ParseError::UnterminatedArray);
+        case '{':
+        case '[':
+            if (m_limits.max_depth && closers.size() >= m_limits.max_depth)
+                return errorCode(ParseError::DeepNesting);
+            closers.append(c == '{' ? '}' : ']');
+            separators.append(0);
+            ++m_pos;
+            break;
+        case '}':
+        case ']':
+            if (closers.isEmpty() || closers.last() != c)
+                return errorCode(c == ']' ? ParseError::UnterminatedObject : ParseError::UnterminatedArray);
+            closers.removeLast();
+            separators.removeLast();
+            ++m_pos;
+            if (closers.isEmpty())
+                return 0;
+            break;
+        case ',':
+            if (m_limits.max_elements && ++separators.last() >= m_limits.max_elements)
+                return errorCode(ParseError::DocumentTooLarge);
+            ++m_pos;
+            break;
+        case ':': ++m_pos; break;
+        case '"':
+            if (int err = skipString())
+                return err;
+            break;
+        case 't':
+        case 'f':
+        case 'n':
+            if (int err = skipLiteral())
+                return err;
+            break;
+        default:
+            if (int err = skipNumber())
+                return err;
+            break;
+        }
+    }
+}
+
+
+int checkLimits(QByteArray const &message, JsonLimits const &limits)
+{
+    if (limits.max_bytes && message.size() > limits.max_bytes)
+        return errorCode(ParseError::DocumentTooLarge);
+
+    if (JsonScanner(message).peek() != '[' || !limits.max_batch_size) {
+        JsonScanner scanner(message, limits);
+        if (int err = scanner.skipValue())
+            return err;
+        return scanner.expectEnd();
+    }
+
+    // batch elements are counted here, the batch array itself takes one nesting level
+    JsonLimits element_limits = limits;
+    if (limits.max_depth == 1)
+        return errorCode(ParseError::DeepNesting);
+    if (limits.max_depth)
+        element_limits.max_depth--;
+
+    JsonScanner scanner(message, element_limits);
+    (void)scanner.consume('[');
+    int count = 0;
+    if (!scanner.consume(']')) {
+        do {
+            if (++count > limits.max_batch_size)
+                return errorCode(ParseError::DocumentTooLarge);
+            if (int err = scanner.skipValue())
+                return err;
+        } while (scanner.consume(','));
+
+        if (!scanner.consume(']'))
+            return errorCode(scanner.atEnd() ? ParseError::UnterminatedArray : ParseError::MissingValueSeparator);
+    }
+
+    return scanner.expectEnd();
+}
+
+} // namespace _2_0
+
+} // namespace qjson
+} // namespace rpc
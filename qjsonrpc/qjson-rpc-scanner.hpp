@@ -0,0 +1,74 @@
+#pragma once
+
+#include <qjsonrpc/qjson-rpc.hpp>
+
+#include <QByteArray>
+
+namespace rpc {
+namespace qjson {
+
+inline namespace _2_0 {
+
+// same limit as QJsonDocument uses
+constexpr int const scanner_default_max_depth = 1024;
+
+
+/*
+ * Resource limits checked on raw bytes before any dom is built, 0 - unlimited.
+ * Exceeded depth is ParseError::DeepNesting, anything else ParseError::DocumentTooLarge.
+ **/
+
+struct JsonLimits
+{
+    int max_bytes = 0;
+    int max_depth = scanner_default_max_depth;
+    // per array or object
+    int max_elements = 0;
+    // NOTE: raw bytes between quotes, escape sequences are not decoded
+    int max_string_length = 0;
+    int max_batch_size = 0;
+};
+
+
+/*
+ * Walks raw json bytes by structure alone: nothing is decoded, no dom is built.
+ * All scan/skip methods return 0 or errorCode(ParseError).
+ **/
+
+class LIBQJSONRPC_EXPORT JsonScanner
+{
+public:
+    explicit JsonScanner(QByteArray const &raw, JsonLimits const &limits = JsonLimits());
+
+    [[nodiscard]] int offset() const;
+    [[nodiscard]] bool atEnd() const;
+
+    // NOTE: skips whitespace, returns '\0' at the end of input
+    [[nodiscard]] char peek();
+    [[nodiscard]] bool consume(char c);
+
+    // NOTE: [begin, end) excludes quotes, escape sequences are not decoded
+    [[nodiscard]] int scanString(int &begin, int &end, bool *escaped = nullptr);
+    [[nodiscard]] int skipValue();
+    [[nodiscard]] int expectEnd();
+
+private:
+    [[nodiscard]] int skipString();
+    [[nodiscard]] int skipNumber();
+    [[nodiscard]] int skipLiteral();
+    [[nodiscard]] int skipContainer();
+
+    char const *m_begin;
+    char const *m_pos;
+    char const *m_end;
+    JsonLimits m_limits;
+};
+
+
+// NOTE: whole message (single or batch) against limits, syntax is checked only as far as skipping needs
+[[nodiscard]] LIBQJSONRPC_EXPORT int checkLimits(QByteArray const &message, JsonLimits const &limits);
+
+} // namespace _2_0
+
+} // namespace qjson
+} // namespace rpc
@@ -0,0 +1,466 @@
+#include <qjsonrpc/qjson-rpc-shm.hpp>
+
+#include <qjsonrpc/qjson-rpc-frame.hpp>
+
+#include <QMetaObject>
+#include <QtEndian>
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <new>
+
+#include <fcntl.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace rpc {
+namespace qjson {
+
+inline namespace _2_0 {
+
+// NOTE: positions only grow, ring index is position & (capacity - 1)
+struct ShmChannel::RingHeader
+{
+    alignas(64) std::atomic<quint64> head{ 0 };
+    std::atomic<quint32> reader_waiting{ 0 };
+    alignas(64) std::atomic<quint64> tail{ 0 };
+    std::atomic<quint32> writer_waiting{ 0 };
+    alignas(64) quint32 capacity = 0;
+};
+
+static_assert(std::atomic<quint64>::is_always_lock_free && std::atomic<quint32>::is_always_lock_free,
+              "atomics shared between processes should be lock free");
+
+namespace {
+
+constexpr quint32 const ring_min_capacity = 4096;
+constexpr quint32 const ring_max_capacity = 1u << 30;
+
+[[nodiscard]] int systemError(char const *call)
+{
+    qCDebug(rpcQJson2_0()).noquote() << QObject::tr("shared memory channel: %1 failed: %2")
+                                            .arg(QLatin1String(call))
+                                            .arg(QString::fromLocal8Bit(std::strerror(errno)));
+    return errorCode(SystemError::SharedMemoryUnavailable);
+}
+
+[[nodiscard]] quint32 ringCapacity(int capacity)
+{
+    quint32 result = ring_min_capacity;
+    while (result < static_cast<quint32>(qMax(capacity, 0)) && result < ring_max_capacity)
+        result <<= 1;
+    return result;
+}
+
+void copyIn(char *ring, quint32 capacity, quint64 pos, char const *data, quint64 size)
+{
+    auto const index = static_cast<size_t>(pos & (capacity - 1));
+    auto const first = qMin(static_cast<size_t>(size), capacity - index);
+    std::memcpy(ring + index, data, first);
+    std::memcpy(ring, data + first, static_cast<size_t>(size) - first);
+}
+
+void copyOut(char const *ring, quint32 capacity, quint64 pos, char *data, quint64 size)
+{
+    auto const index = static_cast<size_t>(pos & (capacity - 1));
+    auto const first = qMin(static_cast<size_t>(size), capacity - index);
+    std::memcpy(data, ring + index, first);
+    std::memcpy(data + first, ring, static_cast<size_t>(size) - first);
+}
+
+void drain(int event)
+{
+    eventfd_t value;
+    // NOTE: nonblocking, nothing to drain is fine
+    eventfd_read(event, &value);
+}
+
+} // namespace
+
+
+ShmChannel::ShmChannel(QObject *parent) : QIODevice(parent) {}
+
+ShmChannel::~ShmChannel()
+{
+    release();
+}
+
+int ShmChannel::create(int capacity)
+{
+    if (isOpen())
+        close();
+    m_error = 0;
+
+    quint32 const ring_capacity = ringCapacity(capacity);
+    m_handles.memory = memfd_create("qjsonrpc", MFD_CLOEXEC);
+    if (m_handles.memory < 0)
+        return systemError("memfd_create");
+
+    auto const size = static_cast<off_t>(2 * (sizeof(RingHeader) + ring_capacity));
+    if (ftruncate(m_handles.memory, size) < 0) {
+        int const err = systemError("ftruncate");
+        release();
+        return err;
+    }
+
+    for (int &event : m_handles.events) {
+        event = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (event < 0) {
+            int const err = systemError("eventfd");
+            release();
+            return err;
+        }
+    }
+
+    return map(Creator, ring_capacity);
+}
+
+int ShmChannel::attach(ShmHandles const &handles, Side side)
+{
+    if (isOpen())
+        close();
+    m_error = 0;
+
+    m_handles.memory = fcntl(handles.memory, F_DUPFD_CLOEXEC, 0);
+    if (m_handles.memory < 0)
+        return systemError("fcntl");
+
+    for (int i = 0; i < 4; ++i) {
+        m_handles.events[ i ] = fcntl(handles.events[ i ], F_DUPFD_CLOEXEC, 0);
+        if (m_handles.events[ i ] < 0) {
+            int const err = systemError("fcntl");
+            release();
+            return err;
+        }
+    }
+
+    return map(side, 0);
+}
+
+ShmHandles ShmChannel::handles() const
+{
+    return m_handles;
+}
+
+bool ShmChannel::peekFrame(QByteArray &payload, quint8 *flags)
+{
+    quint64 head, tail;
+    if (!m_rx.header || !positions(m_rx, head, tail))
+        return false;
+
+    quint64 const available = head - tail;
+    if (available < frame_header_size)
+        return false;
+
+    char header[ frame_header_size ];
+    copyOut(m_rx.data, m_rx.capacity, tail, header, frame_header_size);
+    quint32 const length = qFromBigEndian<quint32>(header);
+    if (available < frame_header_size + quint64(length))
+        return false;
+
+    quint64 const begin = tail + frame_header_size;
+    auto const index = static_cast<quint32>(begin & (m_rx.capacity - 1));
+    if (index + quint64(length) <= m_rx.capacity) {
+        payload = QByteArray::fromRawData(m_rx.data + index, static_cast<int>(length));
+    } else {
+        payload = QByteArray(static_cast<int>(length), Qt::Uninitialized);
+        copyOut(m_rx.data, m_rx.capacity, begin, payload.data(), length);
+    }
+
+    if (flags)
+        *flags = static_cast<quint8>(header[ 4 ]);
+    m_peeked_tail = tail;
+    m_peeked = frame_header_size + quint64(length);
+    return true;
+}
+
+void ShmChannel::releaseFrame()
+{
+    if (!m_peeked || !m_rx.header)
+        return;
+
+    advance(m_peeked_tail, m_peeked);
+    m_peeked = 0;
+}
+
+bool ShmChannel::isSequential() const
+{
+    return true;
+}
+
+qint64 ShmChannel::bytesAvailable() const
+{
+    quint64 head, tail;
+    if (!m_rx.header || !positions(m_rx, head, tail))
+        return QIODevice::bytesAvailable();
+
+    return QIODevice::bytesAvailable() + static_cast<qint64>(head - tail);
+}
+
+qint64 ShmChannel::bytesToWrite() const
+{
+    return m_pending.size();
+}
+
+void ShmChannel::close()
+{
+    QIODevice::close();
+    release();
+}
+
+int ShmChannel::error() const
+{
+    return m_error;
+}
+
+qint64 ShmChannel::readData(char *data, qint64 max_size)
+{
+    if (!m_rx.header || m_error)
+        return -1;
+
+    Q_ASSERT(!m_peeked);
+    return pop(data, max_size);
+}
+
+qint64 ShmChannel::writeData(char const *data, qint64 size)
+{
+    if (!m_tx.header || m_error)
+        return -1;
+
+    qint64 written = 0;
+    if (m_pending.isEmpty())
+        written = push(data, size);
+    if (m_error)
+        return -1;
+
+    if (written < size) {
+        m_pending.append(data + written, static_cast<int>(size - written));
+        flush();
+    }
+    return size;
+}
+
+int ShmChannel::map(Side side, quint32 capacity)
+{
+    struct stat st;
+    if (fstat(m_handles.memory, &st) < 0) {
+        int const err = systemError("fstat");
+        release();
+        return err;
+    }
+
+    m_map_size = static_cast<size_t>(st.st_size);
+    m_map = mmap(nullptr, m_map_size, PROT_READ | PROT_WRITE, MAP_SHARED, m_handles.memory, 0);
+    if (m_map == MAP_FAILED) {
+        m_map = nullptr;
+        int const err = systemError("mmap");
+        release();
+        return err;
+    }
+
+    auto *const base = static_cast<char *>(m_map);
+    if (capacity) {
+        for (size_t i = 0; i < 2; ++i)
+            new (base + i * (sizeof(RingHeader) + capacity)) RingHeader;
+    } else if (m_map_size >= sizeof(RingHeader)) {
+        capacity = reinterpret_cast<RingHeader *>(base)->capacity;
+    }
+
+    size_t const stride = sizeof(RingHeader) + capacity;
+    if (capacity < ring_min_capacity || capacity > ring_max_capacity || (capacity & (capacity - 1)) ||
+        m_map_size != 2 * stride) {
+        qCDebug(rpcQJson2_0()).noquote() << QObject::tr("shared memory channel: mapped region is not a channel");
+        release();
+        return errorCode(SystemError::SharedMemoryUnavailable);
+    }
+
+    Ring rings[ 2 ];
+    for (int i = 0; i < 2; ++i) {
+        char *const ring = base + static_cast<size_t>(i) * stride;
+        rings[ i ].header = reinterpret_cast<RingHeader *>(ring);
+        rings[ i ].header->capacity = capacity;
+        rings[ i ].data = ring + sizeof(RingHeader);
+        rings[ i ].capacity = capacity;
+        rings[ i ].data_event = m_handles.events[ 2 * i ];
+        rings[ i ].space_event = m_handles.events[ 2 * i + 1 ];
+    }
+    m_tx = rings[ side == Creator ? 0 : 1 ];
+    m_rx = rings[ side == Creator ? 1 : 0 ];
+
+    m_readable = new QSocketNotifier(m_rx.data_event, QSocketNotifier::Read, this);
+    connect(m_readable, &QSocketNotifier::activated, this, &ShmChannel::onReadable);
+    m_writable = new QSocketNotifier(m_tx.space_event, QSocketNotifier::Read, this);
+    connect(m_writable, &QSocketNotifier::activated, this, &ShmChannel::onWritable);
+
+    // NOTE: whatever the peer has written before attach is reported on the next event loop turn
+    m_seen_head = m_rx.header->tail.load();
+    QIODevice::open(QIODevice::ReadWrite | QIODevice::Unbuffered);
+    QMetaObject::invokeMethod(this, &ShmChannel::onReadable, Qt::QueuedConnection);
+    return 0;
+}
+
+void ShmChannel::release()
+{
+    delete m_readable;
+    m_readable = nullptr;
+    delete m_writable;
+    m_writable = nullptr;
+
+    if (m_map)
+        munmap(m_map, m_map_size);
+    m_map = nullptr;
+    m_map_size = 0;
+    m_tx = Ring();
+    m_rx = Ring();
+
+    if (m_handles.memory >= 0)
+        ::close(m_handles.memory);
+    for (int event : m_handles.events) {
+        if (event >= 0)
+            ::close(event);
+    }
+    m_handles = ShmHandles();
+
+    m_pending.clear();
+    m_seen_head = 0;
+    m_peeked = 0;
+    m_peeked_tail = 0;
+}
+
+void ShmChannel::onReadable()
+{
+    if (!m_rx.header)
+        return;
+
+    drain(m_rx.data_event);
+    for (;;) {
+        quint64 const head = m_rx.header->head.load();
+        if (head != m_seen_head) {
+            m_seen_head = head;
+            emit readyRead();
+            // NOTE: may be closed by a slot
+            if (!m_rx.header)
+                return;
+        }
+
+        // ask writer for a wakeup, then look again in case it has written meanwhile
+        m_rx.header->reader_waiting.store(1);
+        if (m_rx.header->head.load() == m_seen_head)
+            return;
+    }
+}
+
+void ShmChannel::onWritable()
+{
+    if (!m_tx.header)
+        return;
+
+    drain(m_tx.space_event);
+    int const before = m_pending.size();
+    flush();
+    if (m_pending.size() < before)
+        emit bytesWritten(before - m_pending.size());
+}
+
+bool ShmChannel::positions(Ring const &ring, quint64 &head, quint64 &tail) const
+{
+    head = ring.header->head.load(std::memory_order_acquire);
+    tail = ring.header->tail.load(std::memory_order_acquire);
+    if (head - tail <= ring.capacity)
+        return true;
+
+    // NOTE: const since it is reached from bytesAvailable(), channel is closed on next event loop turn
+    const_cast<ShmChannel *>(this)->corrupt();
+    return false;
+}
+
+void ShmChannel::corrupt()
+{
+    if (m_error)
+        return;
+
+    m_error = errorCode(SystemError::SharedMemoryUnavailable);
+    qCDebug(rpcQJson2_0()).noquote() << QObject::tr("shared memory channel: ring positions are corrupt, closing");
+    setErrorString(QString::fromLatin1(qjson::errorString(m_error)));
+    QMetaObject::invokeMethod(this, &ShmChannel::onCorrupt, Qt::QueuedConnection);
+}
+
+void ShmChannel::onCorrupt()
+{
+    // NOTE: channel may be already closed or created anew meanwhile
+    if (m_error && isOpen())
+        close();
+}
+
+qint64 ShmChannel::push(char const *data, qint64 size)
+{
+    RingHeader *const header = m_tx.header;
+    quint64 head, tail;
+    if (!positions(m_tx, head, tail))
+        return 0;
+
+    quint64 const space = m_tx.capacity - (head - tail);
+    auto const count = static_cast<quint64>(qMin(size, static_cast<qint64>(space)));
+    if (!count)
+        return 0;
+
+    copyIn(m_tx.data, m_tx.capacity, head, data, count);
+    // NOTE: sequentially consistent, pairs with reader_waiting store and head load of the reader
+    header->head.store(head + count);
+    if (header->reader_waiting.exchange(0))
+        eventfd_write(m_tx.data_event, 1);
+
+    return static_cast<qint64>(count);
+}
+
+qint64 ShmChannel::pop(char *data, qint64 max_size)
+{
+    quint64 head, tail;
+    if (!positions(m_rx, head, tail))
+        return -1;
+
+    quint64 const available = head - tail;
+    auto const count = static_cast<quint64>(qMin(max_size, static_cast<qint64>(available)));
+    if (!count)
+        return 0;
+
+    copyOut(m_rx.data, m_rx.capacity, tail, data, count);
+    advance(tail, count);
+    return static_cast<qint64>(count);
+}
+
+void ShmChannel::advance(quint64 tail, quint64 size)
+{
+    RingHeader *const header = m_rx.header;
+    header->tail.store(tail + size);
+    if (header->writer_waiting.exchange(0))
+        eventfd_write(m_rx.space_event, 1);
+}
+
+void ShmChannel::flush()
+{
+    while (!m_pending.isEmpty()) {
+        qint64 const pushed = push(m_pending.constData(), m_pending.size());
+        if (m_error)
+            return;
+        if (pushed) {
+            m_pending.remove(0, static_cast<int>(pushed));
+            continue;
+        }
+
+        // ask reader for a wakeup, then look again in case it has read meanwhile
+        m_tx.header->writer_waiting.store(1);
+        quint64 head, tail;
+        if (!positions(m_tx, head, tail) || head - tail == m_tx.capacity)
+            return;
+    }
+}
+
+} // namespace _2_0
+
+} // namespace qjson
+} // namespace rpc
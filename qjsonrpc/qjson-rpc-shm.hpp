@@ -0,0 +1,117 @@
+#pragma once
+
+#include <qjsonrpc/qjson-rpc.hpp>
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QSocketNotifier>
+
+namespace rpc {
+namespace qjson {
+
+inline namespace _2_0 {
+
+// bytes of each direction's ring, rounded up to power of two
+constexpr int const shm_default_capacity = 1024 * 1024;
+
+
+// NOTE: memfd and eventfds of a channel, valid to pass to another process (inherited or SCM_RIGHTS)
+struct ShmHandles
+{
+    int memory = -1;
+    // data and space wakeups of ring 0, then of ring 1
+    int events[ 4 ] = { -1, -1, -1, -1 };
+};
+
+
+/*
+ * Same host transport (Linux only): a pair of single producer single consumer rings
+ * in memfd shared memory with eventfd wakeups, a peer is woken only if it waits.
+ * Sequential device carrying any byte stream, so it goes wherever a socket does.
+ * Frames of FrameCodec layout may be read in place from the mapped region by peekFrame().
+ **/
+
+class LIBQJSONRPC_EXPORT ShmChannel : public QIODevice
+{
+    Q_OBJECT
+
+public:
+    // NOTE: Creator writes ring 0 and reads ring 1, Peer the other way round
+    enum Side
+    {
+        Creator,
+        Peer,
+    };
+
+    explicit ShmChannel(QObject *parent = nullptr);
+    ~ShmChannel() override;
+
+    // both return 0 or error code, channel is open on success
+    [[nodiscard]] int create(int capacity = shm_default_capacity);
+    // NOTE: handles are duplicated, caller keeps its own
+    [[nodiscard]] int attach(ShmHandles const &handles, Side side = Peer);
+
+    [[nodiscard]] ShmHandles handles() const;
+    // NOTE: SharedMemoryUnavailable once the peer has corrupted ring positions, channel gets closed then
+    [[nodiscard]] int error() const;
+
+    // NOTE: payload of the next complete frame, viewed in place unless it wraps around the ring end;
+    //       valid until releaseFrame(), which should go before any other read.
+    //       Frame larger than capacity never completes here, read() it as a stream instead
+    [[nodiscard]] bool peekFrame(QByteArray &payload, quint8 *flags = nullptr);
+    void releaseFrame();
+
+    // QIODevice interface
+    [[nodiscard]] bool isSequential() const override;
+    [[nodiscard]] qint64 bytesAvailable() const override;
+    [[nodiscard]] qint64 bytesToWrite() const override;
+    void close() override;
+
+protected:
+    qint64 readData(char *data, qint64 max_size) override;
+    qint64 writeData(char const *data, qint64 size) override;
+
+private:
+    struct RingHeader;
+
+    struct Ring
+    {
+        RingHeader *header = nullptr;
+        char *data = nullptr;
+        quint32 capacity = 0;
+        int data_event = -1;
+        int space_event = -1;
+    };
+
+    // NOTE: capacity 0 - rings are already initialized by the creator
+    [[nodiscard]] int map(Side side, quint32 capacity);
+    void release();
+    // NOTE: positions are written by the peer too, false if they are out of capacity
+    [[nodiscard]] bool positions(Ring const &ring, quint64 &head, quint64 &tail) const;
+    void corrupt();
+    void onCorrupt();
+    void onReadable();
+    void onWritable();
+    [[nodiscard]] qint64 push(char const *data, qint64 size);
+    [[nodiscard]] qint64 pop(char *data, qint64 max_size);
+    void advance(quint64 tail, quint64 size);
+    void flush();
+
+    ShmHandles m_handles;
+    void *m_map = nullptr;
+    size_t m_map_size = 0;
+    Ring m_tx;
+    Ring m_rx;
+    QSocketNotifier *m_readable = nullptr;
+    QSocketNotifier *m_writable = nullptr;
+    QByteArray m_pending;
+    quint64 m_seen_head = 0;
+    quint64 m_peeked = 0;
+    quint64 m_peeked_tail = 0;
+    int m_error = 0;
+};
+
+} // namespace _2_0
+
+} // namespace qjson
+} // namespace rpc
@@ -0,0 +1,136 @@
+#include <qjsonrpc/qjson-rpc-stream.hpp>
+
+#include <qjsonrpc/qjson-rpc-writer.hpp>
+
+#include <QThread>
+
+
+namespace rpc {
+namespace qjson {
+
+inline namespace _2_0 {
+
+ResultStream::ResultStream(QJsonValue id, QIODevice *device, QObject *parent)
+    : QObject(parent), m_id(qMove(id)), m_device(device), m_gate(device)
+{
+    if (!m_device)
+        return;
+
+    Q_ASSERT(m_device->thread() == QThread::currentThread());
+    connect(m_device, &QIODevice::bytesWritten, this, &ResultStream::onBytesWritten);
+    m_held = !openWriter(m_device, this, [this] { onHead(); });
+}
+
+ResultStream::~ResultStream()
+{
+    if (!m_finished)
+        close();
+}
+
+void ResultStream::setWatermarks(qint64 low, qint64 high)
+{
+    Q_ASSERT(low <= high);
+    m_low_watermark = low;
+    m_high_watermark = high;
+}
+
+void ResultStream::append(QJsonValue const &element)
+{
+    appendRaw(toJson(element));
+}
+
+void ResultStream::appendRaw(QByteArray const &element)
+{
+    Q_ASSERT(!m_finished);
+    if (m_finished)
+        return;
+
+    if (m_count++)
+        write(QByteArray(",", 1));
+    else
+        write(resultResponseHead(m_id) + '[');
+    write(element);
+
+    if (m_device && m_device->bytesToWrite() >= m_high_watermark)
+        m_waiting = true;
+}
+
+void ResultStream::finish()
+{
+    if (m_finished)
+        return;
+
+    if (!m_count)
+        write(resultResponseHead(m_id) + '[');
+    write(QByteArray("]}", 2));
+
+    close();
+    emit finished();
+}
+
+void ResultStream::fail(ErrorObject const &error)
+{
+    if (m_finished)
+        return;
+
+    if (m_count) {
+        qCDebug(rpcQJson2_0()).noquote() << QObject::tr("result is already partially sent, error is dropped");
+        finish();
+        return;
+    }
+
+    write(toJson(ResponseObject(error, m_id)));
+
+    close();
+    emit finished();
+}
+
+bool ResultStream::canWrite() const
+{
+    return !m_finished && !m_waiting && !m_held;
+}
+
+int ResultStream::count() const
+{
+    return m_count;
+}
+
+bool ResultStream::isFinished() const
+{
+    return m_finished;
+}
+
+void ResultStream::write(QByteArray const &data)
+{
+    if (m_device)
+        writePartial(m_device, this, data);
+}
+
+void ResultStream::close()
+{
+    m_finished = true;
+    if (m_gate)
+        closeWriter(m_gate, this, !m_device);
+}
+
+void ResultStream::onHead()
+{
+    m_held = false;
+    if (!m_finished && !m_waiting)
+        emit readyForMore();
+}
+
+void ResultStream::onBytesWritten()
+{
+    if (!m_waiting || m_device->bytesToWrite() > m_low_watermark)
+        return;
+
+    m_waiting = false;
+    if (!m_finished && !m_held)
+        emit readyForMore();
+}
+
+} // namespace _2_0
+
+} // namespace qjson
+} // namespace rpc
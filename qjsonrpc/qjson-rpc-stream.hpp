@@ -0,0 +1,79 @@
+#pragma once
+
+#include <qjsonrpc/qjson-rpc.hpp>
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QObject>
+#include <QPointer>
+
+namespace rpc {
+namespace qjson {
+
+inline namespace _2_0 {
+
+// defaults of device's pending output bytes watermarks
+constexpr qint64 const stream_low_watermark = 256 * 1024;
+constexpr qint64 const stream_high_watermark = 1024 * 1024;
+
+
+/*
+ * Writes response with array result element by element straight to the device,
+ * so neither the whole result nor its serialized form is kept in memory.
+ * Backpressure: canWrite() turns false once device has more than high watermark
+ * bytes pending, readyForMore() is emitted when it drains below low watermark.
+ * Stream is a partial writer of the device (see writeMessage()), so other responses and
+ * notifications written meanwhile are held until it finishes; while another partial writer
+ * holds the device, canWrite() is false and readyForMore() follows once this stream gets it.
+ **/
+
+class LIBQJSONRPC_EXPORT ResultStream : public QObject
+{
+    Q_OBJECT
+
+public:
+    // NOTE: null device drops everything (e.g. stream for notification),
+    //       otherwise stream is created and used in device's thread
+    ResultStream(QJsonValue id, QIODevice *device, QObject *parent = nullptr);
+    ~ResultStream() override;
+
+    void setWatermarks(qint64 low, qint64 high);
+
+    void append(QJsonValue const &element);
+    // NOTE: element should be serialized json value
+    void appendRaw(QByteArray const &element);
+
+    void finish();
+    // NOTE: possible only until the first element, afterwards result is already on the wire and just gets finished
+    void fail(ErrorObject const &error);
+
+    [[nodiscard]] bool canWrite() const;
+    [[nodiscard]] int count() const;
+    [[nodiscard]] bool isFinished() const;
+
+signals:
+    void readyForMore();
+    void finished();
+
+private:
+    void write(QByteArray const &data);
+    void onBytesWritten();
+    void onHead();
+    void close();
+
+    QJsonValue m_id;
+    QPointer<QIODevice> m_device;
+    // NOTE: key of the writer, kept after device is destroyed
+    QIODevice *m_gate = nullptr;
+    qint64 m_low_watermark = stream_low_watermark;
+    qint64 m_high_watermark = stream_high_watermark;
+    int m_count = 0;
+    bool m_waiting = false;
+    bool m_held = false;
+    bool m_finished = false;
+};
+
+} // namespace _2_0
+
+} // namespace qjson
+} // namespace rpc
@@ -0,0 +1,761 @@
+#include <qjsonrpc/qjson-rpc-uring.hpp>
+
+#include <qjsonrpc/qjson-rpc-frame.hpp>
+
+#include <unistd.h>
+
+#ifdef QJSONRPC_WITH_IO_URING
+#include <QHash>
+#include <QMetaObject>
+#include <QSharedPointer>
+#include <QSocketNotifier>
+#include <QThread>
+#include <QVector>
+#include <QtEndian>
+
+#include <cerrno>
+#include <cstring>
+#include <limits>
+
+#include <liburing.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#endif
+
+
+namespace rpc {
+namespace qjson {
+
+inline namespace _2_0 {
+
+#ifdef QJSONRPC_WITH_IO_URING
+
+namespace {
+
+// NOTE: user data of an operation is connection id shifted left by operation_bits with operation in low bits
+enum Operation : quint64
+{
+    Accept,
+    Recv,
+    Send,
+};
+
+// copy of completion queue entry
+struct Completion
+{
+    quint64 data;
+    int res;
+    unsigned flags;
+};
+
+constexpr int const operation_bits = 2;
+constexpr quint64 const operation_mask = (1u << operation_bits) - 1;
+constexpr unsigned const ring_entries = 4096;
+constexpr int const buffer_group = 0;
+constexpr int const buffer_max_count = 32768;
+
+[[nodiscard]] int systemError(char const *call, int err, SystemError error)
+{
+    qCDebug(rpcQJson2_0()).noquote() << QObject::tr("io_uring server: %1 failed: %2")
+                                            .arg(QLatin1String(call))
+                                            .arg(QString::fromLocal8Bit(std::strerror(err)));
+    return errorCode(error);
+}
+
+[[nodiscard]] int bufferCount(int count)
+{
+    int result = 1;
+    while (result < count && result < buffer_max_count)
+        result <<= 1;
+    return result;
+}
+
+// NOTE: provided buffer rings are 5.19+, but multishot recv is 6.0+, so try the latter on a socketpair:
+//       older kernels reject it with EINVAL or complete it without IORING_CQE_F_MORE
+[[nodiscard]] bool probeMultishotRecv(io_uring &ring)
+{
+    int ret = 0;
+    io_uring_buf_ring *const buffers = io_uring_setup_buf_ring(&ring, 1, buffer_group, 0, &ret);
+    if (!buffers)
+        return false;
+
+    char buffer[ 16 ];
+    io_uring_buf_ring_add(buffers, buffer, sizeof(buffer), 0, io_uring_buf_ring_mask(1), 0);
+    io_uring_buf_ring_advance(buffers, 1);
+
+    bool result = false;
+    int sockets[ 2 ];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sockets) == 0) {
+        io_uring_sqe *const entry = io_uring_get_sqe(&ring);
+        io_uring_prep_recv_multishot(entry, sockets[ 0 ], nullptr, 0, 0);
+        entry->flags |= IOSQE_BUFFER_SELECT;
+        entry->buf_group = buffer_group;
+
+        char const byte = 0;
+        io_uring_cqe *cqe = nullptr;
+        bool armed = false;
+        if (io_uring_submit(&ring) == 1 && ::write(sockets[ 1 ], &byte, 1) == 1 && io_uring_wait_cqe(&ring, &cqe) == 0) {
+            armed = cqe->flags & IORING_CQE_F_MORE;
+            result = armed && cqe->res == 1;
+            io_uring_cqe_seen(&ring, cqe);
+        }
+
+        // end of stream finishes still armed recv before its buffers go away
+        ::close(sockets[ 1 ]);
+        while (armed && io_uring_wait_cqe(&ring, &cqe) == 0) {
+            armed = cqe->flags & IORING_CQE_F_MORE;
+            io_uring_cqe_seen(&ring, cqe);
+        }
+        ::close(sockets[ 0 ]);
+    }
+
+    io_uring_free_buf_ring(&ring, buffers, 1, buffer_group);
+    return result;
+}
+
+} // namespace
+
+
+struct UringServer::Private
+{
+    struct Connection
+    {
+        int fd = -1;
+        FrameCodec codec;
+        // frames queued since the last flush and the ones being sent now
+        QByteArray out;
+        QByteArray sending;
+        int sent = 0;
+        // armed operations, descriptor is closed once none is left
+        int pending = 0;
+        bool dirty = false;
+        bool closing = false;
+    };
+
+    using ConnectionPtr = QSharedPointer<Connection>;
+
+    explicit Private(UringServer *q) : q(q) {}
+
+    [[nodiscard]] int start(int socket);
+    void release();
+
+    [[nodiscard]] io_uring_sqe *sqe();
+    void armAccept();
+    void armRecv(quint64 id, Connection &connection);
+    void armSend(quint64 id, Connection &connection);
+    void provide(int bid);
+
+    void onEvent();
+    void onAccept(int res, unsigned flags);
+    void onRecv(quint64 id, int res, unsigned flags);
+    void onSend(quint64 id, int res);
+    void decode(quint64 id, ConnectionPtr const &connection);
+    void shutdown(Connection &connection);
+    void finish(quint64 id);
+
+    void markDirty(quint64 id, Connection &connection);
+    void flush();
+
+    UringServer *const q;
+    int buffer_count = uring_default_buffer_count;
+    int buffer_size = uring_default_buffer_size;
+    bool compression = false;
+    int max_size = 0;
+
+    io_uring ring;
+    bool ring_ready = false;
+    io_uring_buf_ring *buffers = nullptr;
+    QByteArray buffer_memory;
+    // buffers given back since the last advance
+    int provided = 0;
+    int event = -1;
+    QSocketNotifier *notifier = nullptr;
+    int listener = -1;
+    bool accepting = false;
+
+    quint64 next_id = 1;
+    QHash<quint64, ConnectionPtr> connections;
+    QVector<quint64> dirty;
+    bool flush_scheduled = false;
+    bool in_event = false;
+};
+
+int UringServer::Private::start(int socket)
+{
+    listener = socket;
+
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_SUBMIT_ALL | IORING_SETUP_COOP_TASKRUN;
+    int ret = io_uring_queue_init_params(ring_entries, &ring, &params);
+    if (ret == -EINVAL) {
+        // NOTE: setup flags are 5.18+, multishot operations need newer kernel anyway
+        std::memset(&params, 0, sizeof(params));
+        ret = io_uring_queue_init_params(ring_entries, &ring, &params);
+    }
+    if (ret < 0)
+        return systemError("io_uring_queue_init_params", -ret, SystemError::IoUringUnavailable);
+    ring_ready = true;
+
+    int const count = bufferCount(buffer_count);
+    buffers = io_uring_setup_buf_ring(&ring, static_cast<unsigned>(count), buffer_group, 0, &ret);
+    if (!buffers)
+        return systemError("io_uring_setup_buf_ring", -ret, SystemError::IoUringUnavailable);
+    buffer_count = count;
+    buffer_memory = QByteArray(buffer_count * buffer_size, Qt::Uninitialized);
+    for (int bid = 0; bid < buffer_count; ++bid)
+        provide(bid);
+    io_uring_buf_ring_advance(buffers, provided);
+    provided = 0;
+
+    event = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (event < 0)
+        return systemError("eventfd", errno, SystemError::IoUringUnavailable);
+    ret = io_uring_register_eventfd(&ring, event);
+    if (ret < 0)
+        return systemError("io_uring_register_eventfd", -ret, SystemError::IoUringUnavailable);
+
+    notifier = new QSocketNotifier(event, QSocketNotifier::Read, q);
+    QObject::connect(notifier, &QSocketNotifier::activated, q, [this] { onEvent(); });
+
+    armAccept();
+    ret = io_uring_submit(&ring);
+    if (ret < 0)
+        return systemError("io_uring_submit", -ret, SystemError::IoUringUnavailable);
+
+    return 0;
+}
+
+void UringServer::Private::release()
+{
+    delete notifier;
+    notifier = nullptr;
+
+    if (ring_ready) {
+        if (buffers)
+            io_uring_free_buf_ring(&ring, buffers, static_cast<unsigned>(buffer_count), buffer_group);
+        // NOTE: cancels everything still armed
+        io_uring_queue_exit(&ring);
+    }
+    ring_ready = false;
+    buffers = nullptr;
+    buffer_memory = QByteArray();
+    provided = 0;
+
+    if (event >= 0)
+        ::close(event);
+    event = -1;
+    if (listener >= 0)
+        ::close(listener);
+    listener = -1;
+    accepting = false;
+
+    QList<quint64> const ids = connections.keys();
+    for (ConnectionPtr const &connection : qAsConst(connections)) {
+        // NOTE: completions still being handled must not rearm on the ring which is gone
+        connection->closing = true;
+        ::close(connection->fd);
+    }
+    connections.clear();
+    dirty.clear();
+    for (quint64 id : ids)
+        emit q->disconnected(id);
+}
+
+io_uring_sqe *UringServer::Private::sqe()
+{
+    io_uring_sqe *result = io_uring_get_sqe(&ring);
+    if (!result) {
+        // NOTE: submission queue is full, hand it over to the kernel and take a fresh entry
+        io_uring_submit(&ring);
+        result = io_uring_get_sqe(&ring);
+    }
+    if (!result)
+        qCDebug(rpcQJson2_0()).noquote() << QObject::tr("io_uring server: submission queue is full");
+    return result;
+}
+
+void UringServer::Private::armAccept()
+{
+    io_uring_sqe *const entry = sqe();
+    if (!entry)
+        return;
+
+    io_uring_prep_multishot_accept(entry, listener, nullptr, nullptr, SOCK_CLOEXEC);
+    io_uring_sqe_set_data64(entry, Accept);
+    accepting = true;
+}
+
+void UringServer::Private::armRecv(quint64 id, Connection &connection)
+{
+    io_uring_sqe *const entry = sqe();
+    if (!entry) {
+        shutdown(connection);
+        return;
+    }
+
+    io_uring_prep_recv_multishot(entry, connection.fd, nullptr, 0, 0);
+    entry->flags |= IOSQE_BUFFER_SELECT;
+    entry->buf_group = buffer_group;
+    io_uring_sqe_set_data64(entry, (id << operation_bits) | Recv);
+    ++connection.pending;
+}
+
+void UringServer::Private::armSend(quint64 id, Connection &connection)
+{
+    io_uring_sqe *const entry = sqe();
+    if (!entry) {
+        shutdown(connection);
+        return;
+    }
+
+    io_uring_prep_send(entry, connection.fd, connection.sending.constData() + connection.sent,
+                       static_cast<size_t>(connection.sending.size() - connection.sent), MSG_NOSIGNAL);
+    io_uring_sqe_set_data64(entry, (id << operation_bits) | Send);
+    ++connection.pending;
+}
+
+void UringServer::Private::provide(int bid)
+{
+    io_uring_buf_ring_add(buffers, buffer_memory.data() + bid * buffer_size, static_cast<unsigned>(buffer_size),
+                          static_cast<unsigned short>(bid), io_uring_buf_ring_mask(static_cast<unsigned>(buffer_count)),
+                          provided++);
+}
+
+void UringServer::Private::onEvent()
+{
+    eventfd_t value;
+    // NOTE: nonblocking, completions are reaped below regardless
+    eventfd_read(event, &value);
+
+    // NOTE: completion queue is released before any signal, so slots may send and abort freely
+    QVector<Completion> completions;
+    unsigned head;
+    unsigned seen = 0;
+    io_uring_cqe *cqe;
+    io_uring_for_each_cqe(&ring, head, cqe)
+    {
+        completions.append({ io_uring_cqe_get_data64(cqe), cqe->res, cqe->flags });
+        ++seen;
+    }
+    io_uring_cq_advance(&ring, seen);
+
+    in_event = true;
+    for (Completion const &completion : qAsConst(completions)) {
+        quint64 const id = completion.data >> operation_bits;
+        switch (completion.data & operation_mask) {
+        case Accept:
+            onAccept(completion.res, completion.flags);
+            break;
+        case Recv:
+            onRecv(id, completion.res, completion.flags);
+            break;
+        case Send:
+            onSend(id, completion.res);
+            break;
+        }
+    }
+    in_event = false;
+
+    if (provided) {
+        io_uring_buf_ring_advance(buffers, provided);
+        provided = 0;
+    }
+    flush();
+}
+
+void UringServer::Private::onAccept(int res, unsigned flags)
+{
+    if (!(flags & IORING_CQE_F_MORE))
+        accepting = false;
+
+    if (res < 0) {
+        if (res != -ECANCELED)
+            qCDebug(rpcQJson2_0()).noquote()
+                << QObject::tr("io_uring server: accept failed: %1").arg(QString::fromLocal8Bit(std::strerror(-res)));
+    } else {
+        int const on = 1;
+        setsockopt(res, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+
+        ConnectionPtr const connection = ConnectionPtr::create();
+        connection->fd = res;
+        connection->codec.setCompressionEnabled(compression);
+        connection->codec.setMaxMessageSize(max_size);
+
+        quint64 const id = next_id++;
+        connections.insert(id, connection);
+        armRecv(id, *connection);
+        emit q->connected(id);
+        finish(id);
+    }
+
+    if (!accepting && listener >= 0)
+        armAccept();
+}
+
+void UringServer::Private::onRecv(quint64 id, int res, unsigned flags)
+{
+    ConnectionPtr const connection = connections.value(id);
+    if (!connection)
+        return;
+
+    if (flags & IORING_CQE_F_BUFFER) {
+        auto const bid = static_cast<int>(flags >> IORING_CQE_BUFFER_SHIFT);
+        // NOTE: codec copies, so buffer goes back to the kernel right away
+        if (res > 0)
+            connection->codec.append(QByteArray::fromRawData(buffer_memory.constData() + bid * buffer_size, res));
+        provide(bid);
+    }
+
+    bool const more = flags & IORING_CQE_F_MORE;
+    if (!more)
+        --connection->pending;
+
+    if (res > 0) {
+        decode(id, connection);
+    } else if (res == 0) {
+        shutdown(*connection);
+    } else if (res != -ENOBUFS) {
+        if (!connection->closing)
+            qCDebug(rpcQJson2_0()).noquote() << QObject::tr("io_uring server: connection %1: recv failed: %2")
+                                                    .arg(id)
+                                                    .arg(QString::fromLocal8Bit(std::strerror(-res)));
+        shutdown(*connection);
+    }
+
+    // NOTE: -ENOBUFS - all buffers are queued, rearm once they are given back below
+    if (!more && !connection->closing)
+        armRecv(id, *connection);
+
+    finish(id);
+}
+
+void UringServer::Private::onSend(quint64 id, int res)
+{
+    ConnectionPtr const connection = connections.value(id);
+    if (!connection)
+        return;
+
+    --connection->pending;
+    if (res < 0) {
+        if (!connection->closing)
+            qCDebug(rpcQJson2_0()).noquote() << QObject::tr("io_uring server: connection %1: send failed: %2")
+                                                    .arg(id)
+                                                    .arg(QString::fromLocal8Bit(std::strerror(-res)));
+        shutdown(*connection);
+    } else if (!connection->closing) {
+        connection->sent += res;
+        if (connection->sent < connection->sending.size()) {
+            armSend(id, *connection);
+        } else {
+            connection->sending.clear();
+            connection->sent = 0;
+            if (!connection->out.isEmpty())
+                markDirty(id, *connection);
+        }
+    }
+
+    finish(id);
+}
+
+void UringServer::Private::decode(quint64 id, ConnectionPtr const &connection)
+{
+    QByteArray message;
+    while (!connection->closing) {
+        if (int err = connection->codec.decode(message)) {
+            qCDebug(rpcQJson2_0()).noquote()
+                << QObject::tr("io_uring server: connection %1: %2").arg(id).arg(errorString(err));
+            // NOTE: frame boundary is lost
+            if (err == errorCode(TransportError::FrameInvalid) && !connection->codec.bufferedBytes()) {
+                shutdown(*connection);
+                return;
+            }
+            continue;
+        }
+        if (message.isNull())
+            return;
+
+        emit q->messageReceived(id, message);
+    }
+}
+
+void UringServer::Private::shutdown(Connection &connection)
+{
+    if (connection.closing)
+        return;
+
+    // NOTE: armed operations complete with end of stream or error, descriptor is closed after the last one
+    connection.closing = true;
+    connection.out.clear();
+    ::shutdown(connection.fd, SHUT_RDWR);
+}
+
+void UringServer::Private::finish(quint64 id)
+{
+    ConnectionPtr const connection = connections.value(id);
+    if (!connection || !connection->closing || connection->pending)
+        return;
+
+    ::close(connection->fd);
+    connections.remove(id);
+    emit q->disconnected(id);
+}
+
+void UringServer::Private::markDirty(quint64 id, Connection &connection)
+{
+    if (connection.dirty)
+        return;
+
+    connection.dirty = true;
+    dirty.append(id);
+    if (in_event || flush_scheduled)
+        return;
+
+    // NOTE: sends of the whole event loop pass go with one submit
+    flush_scheduled = true;
+    QMetaObject::invokeMethod(q, [this] { flush(); }, Qt::QueuedConnection);
+}
+
+void UringServer::Private::flush()
+{
+    flush_scheduled = false;
+    if (!ring_ready)
+        return;
+
+    for (quint64 id : qAsConst(dirty)) {
+        ConnectionPtr const connection = connections.value(id);
+        if (!connection)
+            continue;
+
+        connection->dirty = false;
+        // NOTE: the rest goes once the send in flight completes
+        if (connection->closing || !connection->sending.isEmpty() || connection->out.isEmpty())
+            continue;
+
+        connection->sending.swap(connection->out);
+        connection->sent = 0;
+        armSend(id, *connection);
+        finish(id);
+    }
+    dirty.clear();
+
+    int const ret = io_uring_submit(&ring);
+    if (ret < 0)
+        qCDebug(rpcQJson2_0()).noquote() << QObject::tr("io_uring server: submit failed: %1")
+                                                .arg(QString::fromLocal8Bit(std::strerror(-ret)));
+}
+
+
+UringServer::UringServer(QObject *parent) : QObject(parent), d(new Private(this)) {}
+
+UringServer::~UringServer()
+{
+    QSignalBlocker const blocker(this);
+    d->release();
+    delete d;
+}
+
+bool UringServer::isAvailable()
+{
+    static bool const available = [] {
+        io_uring ring;
+        if (io_uring_queue_init(8, &ring, 0) < 0)
+            return false;
+
+        bool const result = probeMultishotRecv(ring);
+        io_uring_queue_exit(&ring);
+        return result;
+    }();
+
+    return available;
+}
+
+void UringServer::setBuffers(int count, int size)
+{
+    Q_ASSERT(count > 0 && size > 0);
+    d->buffer_count = qBound(1, count, buffer_max_count);
+    d->buffer_size = qBound(1, size, std::numeric_limits<int>::max() / bufferCount(d->buffer_count));
+}
+
+void UringServer::setCompressionEnabled(bool enabled)
+{
+    d->compression = enabled;
+}
+
+void UringServer::setMaxMessageSize(int bytes)
+{
+    d->max_size = qMax(0, bytes);
+}
+
+int UringServer::listen(QString const &address, quint16 port)
+{
+    sockaddr_storage storage;
+    std::memset(&storage, 0, sizeof(storage));
+    socklen_t length = 0;
+
+    QByteArray const host = address.toLatin1();
+    auto *const v4 = reinterpret_cast<sockaddr_in *>(&storage);
+    auto *const v6 = reinterpret_cast<sockaddr_in6 *>(&storage);
+    if (inet_pton(AF_INET, host.constData(), &v4->sin_addr) == 1) {
+        v4->sin_family = AF_INET;
+        v4->sin_port = qToBigEndian(port);
+        length = sizeof(sockaddr_in);
+    } else if (inet_pton(AF_INET6, host.constData(), &v6->sin6_addr) == 1) {
+        v6->sin6_family = AF_INET6;
+        v6->sin6_port = qToBigEndian(port);
+        length = sizeof(sockaddr_in6);
+    } else {
+        qCDebug(rpcQJson2_0()).noquote() << QObject::tr("io_uring server: bad address %1").arg(address);
+        return errorCode(SystemError::ListenFailed);
+    }
+
+    int const socket = ::socket(storage.ss_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (socket < 0)
+        return systemError("socket", errno, SystemError::ListenFailed);
+
+    int const on = 1;
+    setsockopt(socket, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    if (::bind(socket, reinterpret_cast<sockaddr *>(&storage), length) < 0 || ::listen(socket, SOMAXCONN) < 0) {
+        int const err = systemError("bind", errno, SystemError::ListenFailed);
+        ::close(socket);
+        return err;
+    }
+
+    return listen(socket);
+}
+
+int UringServer::listen(int socket)
+{
+    close();
+
+    if (!isAvailable()) {
+        ::close(socket);
+        return errorCode(SystemError::IoUringUnavailable);
+    }
+
+    if (int err = d->start(socket)) {
+        d->release();
+        return err;
+    }
+
+    return 0;
+}
+
+void UringServer::close()
+{
+    d->release();
+}
+
+bool UringServer::isListening() const
+{
+    return d->listener >= 0;
+}
+
+quint16 UringServer::port() const
+{
+    sockaddr_storage storage;
+    socklen_t length = sizeof(storage);
+    if (d->listener < 0 || getsockname(d->listener, reinterpret_cast<sockaddr *>(&storage), &length) < 0)
+        return 0;
+
+    if (storage.ss_family == AF_INET6)
+        return qFromBigEndian(reinterpret_cast<sockaddr_in6 const *>(&storage)->sin6_port);
+    return qFromBigEndian(reinterpret_cast<sockaddr_in const *>(&storage)->sin_port);
+}
+
+int UringServer::connectionCount() const
+{
+    return d->connections.size();
+}
+
+void UringServer::send(quint64 connection, QByteArray const &message)
+{
+    if (QThread::currentThread() != thread()) {
+        QMetaObject::invokeMethod(this, [this, connection, message] { send(connection, message); },
+                                  Qt::QueuedConnection);
+        return;
+    }
+
+    Private::ConnectionPtr const target = d->connections.value(connection);
+    if (!target || target->closing)
+        return;
+
+    target->out += target->codec.encode(message);
+    d->markDirty(connection, *target);
+}
+
+void UringServer::abort(quint64 connection)
+{
+    Private::ConnectionPtr const target = d->connections.value(connection);
+    if (!target)
+        return;
+
+    d->shutdown(*target);
+    d->finish(connection);
+}
+
+#else
+
+struct UringServer::Private
+{
+};
+
+UringServer::UringServer(QObject *parent) : QObject(parent) {}
+
+UringServer::~UringServer() = default;
+
+bool UringServer::isAvailable()
+{
+    return false;
+}
+
+void UringServer::setBuffers(int, int) {}
+
+void UringServer::setCompressionEnabled(bool) {}
+
+void UringServer::setMaxMessageSize(int) {}
+
+int UringServer::listen(QString const &, quint16)
+{
+    qCDebug(rpcQJson2_0()).noquote() << QObject::tr("io_uring server: built without QJSONRPC_WITH_IO_URING");
+    return errorCode(SystemError::IoUringUnavailable);
+}
+
+int UringServer::listen(int socket)
+{
+    ::close(socket);
+    qCDebug(rpcQJson2_0()).noquote() << QObject::tr("io_uring server: built without QJSONRPC_WITH_IO_URING");
+    return errorCode(SystemError::IoUringUnavailable);
+}
+
+void UringServer::close() {}
+
+bool UringServer::isListening() const
+{
+    return false;
+}
+
+quint16 UringServer::port() const
+{
+    return 0;
+}
+
+int UringServer::connectionCount() const
+{
+    return 0;
+}
+
+void UringServer::send(quint64, QByteArray const &) {}
+
+void UringServer::abort(quint64) {}
+
+#endif
+
+} // namespace _2_0
+
+} // namespace qjson
+} // namespace rpc
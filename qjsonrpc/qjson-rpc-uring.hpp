@@ -0,0 +1,73 @@
+#pragma once
+
+#include <qjsonrpc/qjson-rpc.hpp>
+
+#include <QByteArray>
+#include <QObject>
+#include <QString>
+
+namespace rpc {
+namespace qjson {
+
+inline namespace _2_0 {
+
+// defaults of provided receive buffers, count is rounded up to power of two
+constexpr int const uring_default_buffer_count = 1024;
+constexpr int const uring_default_buffer_size = 16 * 1024;
+
+
+/*
+ * Linux only TCP server on io_uring: multishot accept and recv into a ring of provided buffers,
+ * outgoing frames of every connection are coalesced and all sends go with one submit per event loop pass.
+ * Completions are signalled through an eventfd watched by the event loop, received bytes go straight
+ * into connection's FrameCodec. Built only with QJSONRPC_WITH_IO_URING and kernel 6.0+,
+ * otherwise isAvailable() is false and listen() fails, so use QTcpServer then.
+ **/
+
+class LIBQJSONRPC_EXPORT UringServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit UringServer(QObject *parent = nullptr);
+    ~UringServer() override;
+
+    // NOTE: probes kernel support once
+    [[nodiscard]] static bool isAvailable();
+
+    // NOTE: take effect on next listen()
+    void setBuffers(int count, int size);
+    void setCompressionEnabled(bool enabled);
+    // NOTE: 0 - unlimited, see FrameCodec::setMaxMessageSize()
+    void setMaxMessageSize(int bytes);
+
+    // both return 0 or error code; address is numeric IPv4 or IPv6 one
+    [[nodiscard]] int listen(QString const &address, quint16 port);
+    // NOTE: takes ownership of bound and listening socket, it is closed on failure too
+    [[nodiscard]] int listen(int socket);
+    void close();
+
+    [[nodiscard]] bool isListening() const;
+    [[nodiscard]] quint16 port() const;
+    [[nodiscard]] int connectionCount() const;
+
+    // NOTE: message is framed here; callable from any thread
+    void send(quint64 connection, QByteArray const &message);
+    // NOTE: pending output is dropped
+    void abort(quint64 connection);
+
+signals:
+    void connected(quint64 connection);
+    void disconnected(quint64 connection);
+    void messageReceived(quint64 connection, QByteArray const &message);
+
+private:
+    struct Private;
+
+    Private *d = nullptr;
+};
+
+} // namespace _2_0
+
+} // namespace qjson
+} // namespace rpc
@@ -0,0 +1,237 @@
+#include <qjsonrpc/qjson-rpc-writer.hpp>
+
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QList>
+#include <QMetaObject>
+#include <QThread>
+
+
+namespace rpc {
+namespace qjson {
+
+inline namespace _2_0 {
+
+namespace {
+
+// NOTE: whole message is an entry without writer, closed from the start
+struct GateEntry
+{
+    void const *writer;
+    QByteArray held;
+    bool closed;
+    std::function<void()> on_head;
+};
+
+struct Gate
+{
+    QList<GateEntry> entries;
+    // NOTE: gate goes away with the device, writers outliving it have nothing to close
+    QMetaObject::Connection destroyed;
+};
+
+// NOTE: calls for a device come from its thread only, so every thread keeps gates of its devices
+//       and nothing is locked; device is present only while it has an open partial writer or held output
+using Queues = QHash<QIODevice const *, Gate>;
+
+[[nodiscard]] Queues &queues()
+{
+    thread_local Queues instance;
+    return instance;
+}
+
+} // namespace
+
+
+QByteArray toJson(QJsonValue const &value)
+{
+    switch (value.type()) {
+    case QJsonValue::Object: return QJsonDocument(value.toObject()).toJson(QJsonDocument::Compact);
+    case QJsonValue::Array: return QJsonDocument(value.toArray()).toJson(QJsonDocument::Compact);
+    case QJsonValue::Undefined: return QByteArray();
+    default: {
+        // strip brackets of the single element array
+        QByteArray const json = QJsonDocument(QJsonArray({ value })).toJson(QJsonDocument::Compact);
+        return json.mid(1, json.size() - 2);
+    }
+    }
+}
+
+QByteArray resultResponseHead(QJsonValue const &id)
+{
+    static constexpr char const prefix[] = "{\"id\":";
+    static constexpr char const middle[] = ",\"jsonrpc\":\"2.0\",\"result\":";
+
+    QByteArray const id_json = toJson(id);
+    QByteArray head;
+    head.reserve(static_cast<int>(sizeof(prefix) + sizeof(middle)) + id_json.size());
+    head.append(prefix, static_cast<int>(sizeof(prefix) - 1));
+    head.append(id_json);
+    head.append(middle, static_cast<int>(sizeof(middle) - 1));
+    return head;
+}
+
+QByteArray resultResponseJson(QJsonValue const &id, QByteArray const &result)
+{
+    QByteArray json = resultResponseHead(id);
+    json.reserve(json.size() + result.size() + 1);
+    json.append(result);
+    json.append('}');
+    return json;
+}
+
+
+void writeMessage(QIODevice *device, QByteArray const &message)
+{
+    if (!device)
+        return;
+    Q_ASSERT(device->thread() == QThread::currentThread());
+
+    Queues &q = queues();
+    if (!q.isEmpty()) {
+        auto const it = q.find(device);
+        if (it != q.end()) {
+            it->entries.append({ nullptr, message, true, {} });
+            return;
+        }
+    }
+    device->write(message);
+}
+
+bool openWriter(QIODevice *device, void const *writer, std::function<void()> on_head)
+{
+    Q_ASSERT(device->thread() == QThread::currentThread());
+    Gate &gate = queues()[ device ];
+    if (gate.entries.isEmpty())
+        gate.destroyed = QObject::connect(device, &QObject::destroyed, [device] { queues().remove(device); });
+    gate.entries.append({ writer, QByteArray(), false, qMove(on_head) });
+    return gate.entries.size() == 1;
+}
+
+void writePartial(QIODevice *device, void const *writer, QByteArray const &data)
+{
+    Q_ASSERT(device->thread() == QThread::currentThread());
+    Queues &q = queues();
+    auto const it = q.find(device);
+    if (it != q.end() && it->entries.first().writer != writer) {
+        for (GateEntry &entry : it->entries) {
+            if (entry.writer == writer) {
+                entry.held.append(data);
+                return;
+            }
+        }
+    }
+    device->write(data);
+}
+
+void closeWriter(QIODevice *device, void const *writer, bool dropped)
+{
+    Queues &q = queues();
+    auto const it = q.find(device);
+    if (it == q.end())
+        return;
+
+    if (dropped) {
+        QObject::disconnect(it->destroyed);
+        q.erase(it);
+        return;
+    }
+
+    QList<GateEntry> &entries = it->entries;
+    if (entries.first().writer != writer) {
+        for (GateEntry &entry : entries) {
+            if (entry.writer == writer)
+                entry.closed = true;
+        }
+        return;
+    }
+
+    // NOTE: head is closed, release held output up to the next open writer, which becomes the head
+    QList<QByteArray> output;
+    std::function<void()> on_head;
+    entries.removeFirst();
+    while (!entries.isEmpty()) {
+        GateEntry &next = entries.first();
+        output.append(qMove(next.held));
+        next.held = QByteArray();
+        if (!next.closed) {
+            on_head = next.on_head;
+            break;
+        }
+        entries.removeFirst();
+    }
+    if (entries.isEmpty()) {
+        QObject::disconnect(it->destroyed);
+        q.erase(it);
+    }
+
+    // NOTE: after the queue is updated, device writes and on_head may write again
+    for (QByteArray const &data : qAsConst(output)) {
+        if (!data.isEmpty())
+            device->write(data);
+    }
+    if (on_head)
+        on_head();
+}
+
+
+BatchResponseWriter::BatchResponseWriter(QIODevice *device) : m_device(device), m_gate(device) {}
+
+BatchResponseWriter::~BatchResponseWriter()
+{
+    if (m_count && !m_finished)
+        closeWriter(m_gate, this, !m_device);
+}
+
+void BatchResponseWriter::write(QByteArray const &response)
+{
+    Q_ASSERT(!m_finished);
+    if (!m_device)
+        return;
+
+    if (!m_count) {
+        // NOTE: output is held while another writer is open, it is ordered anyway
+        bool const head = openWriter(m_device, this, {});
+        Q_UNUSED(head)
+    }
+    writePartial(m_device, this, QByteArray(m_count++ ? "," : "[", 1));
+    writePartial(m_device, this, response);
+}
+
+void BatchResponseWriter::write(ResponseObject const &response)
+{
+    write(QJsonDocument(response).toJson(QJsonDocument::Compact));
+}
+
+void BatchResponseWriter::finish()
+{
+    if (m_finished)
+        return;
+
+    m_finished = true;
+    if (!m_count)
+        return;
+
+    if (m_device) {
+        writePartial(m_device, this, QByteArray("]", 1));
+        closeWriter(m_device, this);
+    } else {
+        closeWriter(m_gate, this, true);
+    }
+}
+
+int BatchResponseWriter::count() const
+{
+    return m_count;
+}
+
+bool BatchResponseWriter::isFinished() const
+{
+    return m_finished;
+}
+
+} // namespace _2_0
+
+} // namespace qjson
+} // namespace rpc
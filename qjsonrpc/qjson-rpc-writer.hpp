@@ -0,0 +1,79 @@
+#pragma once
+
+#include <qjsonrpc/qjson-rpc.hpp>
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QPointer>
+
+#include <functional>
+
+namespace rpc {
+namespace qjson {
+
+inline namespace _2_0 {
+
+// NOTE: compact form, unlike QJsonDocument accepts scalar values too
+[[nodiscard]] LIBQJSONRPC_EXPORT QByteArray toJson(QJsonValue const &value);
+
+// NOTE: response up to result value: {"id":<id>,"jsonrpc":"2.0","result":
+[[nodiscard]] LIBQJSONRPC_EXPORT QByteArray resultResponseHead(QJsonValue const &id);
+
+// NOTE: result should be serialized json value, it is spliced as is
+[[nodiscard]] LIBQJSONRPC_EXPORT QByteArray resultResponseJson(QJsonValue const &id, QByteArray const &result);
+
+
+/*
+ * Output of one device is ordered between partial writers (streamed result, streamed batch),
+ * which put a response on the wire piece by piece over several event loop turns, and whole messages.
+ * While a partial writer is open everything else written through these functions is held
+ * and goes out once it is closed, so nothing lands inside an unfinished response.
+ * Writes bypassing them (plain device->write()) are not ordered.
+ * All calls for a device should come from the device's thread, ordering state is kept per thread.
+ **/
+
+LIBQJSONRPC_EXPORT void writeMessage(QIODevice *device, QByteArray const &message);
+
+// NOTE: writer is any address unique while it is open; returns true if writer may write straight away,
+//       otherwise its output is held and on_head is called once the writers before it are closed
+[[nodiscard]] LIBQJSONRPC_EXPORT bool openWriter(QIODevice *device, void const *writer, std::function<void()> on_head);
+LIBQJSONRPC_EXPORT void writePartial(QIODevice *device, void const *writer, QByteArray const &data);
+// NOTE: dropped - device is destroyed, everything held for it is discarded
+LIBQJSONRPC_EXPORT void closeWriter(QIODevice *device, void const *writer, bool dropped = false);
+
+
+/*
+ * Writes batch response element by element. '[' goes out with the first element,
+ * so a batch without responses (notifications only) produces no bytes at all.
+ * It is a partial writer of the device from the first element until finish().
+ **/
+
+class LIBQJSONRPC_EXPORT BatchResponseWriter
+{
+public:
+    explicit BatchResponseWriter(QIODevice *device);
+    ~BatchResponseWriter();
+
+    // NOTE: response should be serialized compact json object
+    void write(QByteArray const &response);
+    void write(ResponseObject const &response);
+
+    void finish();
+
+    [[nodiscard]] int count() const;
+    [[nodiscard]] bool isFinished() const;
+
+private:
+    Q_DISABLE_COPY(BatchResponseWriter)
+
+    QPointer<QIODevice> m_device;
+    // NOTE: key of the writer, kept after device is destroyed
+    QIODevice *m_gate = nullptr;
+    int m_count = 0;
+    bool m_finished = false;
+};
+
+} // namespace _2_0
+
+} // namespace qjson
+} // namespace rpc
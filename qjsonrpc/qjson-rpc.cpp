@@ -1,20 +1,20 @@
 #include <qjsonrpc/qjson-rpc.hpp>
 
+// NOTE: shared library exports out-of-line definitions of header inline accessors and validators
+#if defined(QJSONRPC_LIBRARY) && !defined(QJSONRPC_STATIC)
+#define QJSONRPC_INLINE
+#include <qjsonrpc/qjson-rpc-inline.hpp>
+#undef QJSONRPC_INLINE
+#endif
+
 #include <QDateTime>
 #include <QJsonArray>
+#include <QJsonDocument>
 #include <QObject>
 
 #include <cmath>
 
 
-[[nodiscard]] static bool isInteger(double d)
-{
-    double const i = std::trunc(d);
-    double const fract = d > .0 ? d - i : d + i;
-    return qIsNull(fract);
-}
-
-
 namespace rpc {
 namespace qjson {
 
@@ -73,11 +73,6 @@ JsonRpcObject &JsonRpcObject::operator=(QJsonObject &&o) noexcept
     return *this;
 }
 
-QString JsonRpcObject::jsonrpc() const
-{
-    return value(latin1string::jsonrpc).toString();
-}
-
 bool JsonRpcObject::isJsonRpcFieldExists() const
 {
     return isJsonRpcFieldExists(*this);
@@ -125,16 +120,6 @@ NotificationObject::NotificationObject(QString method, QJsonValue params) : Json
 
 NotificationObject::NotificationObject(JsonRpcObject obj) : JsonRpcObject(qMove(obj)) {}
 
-QString NotificationObject::method() const
-{
-    return value(latin1string::method).toString();
-}
-
-QJsonValue NotificationObject::params() const
-{
-    return value(latin1string::params);
-}
-
 int NotificationObject::checkMethodField() const
 {
     QJsonValue const method_val = value(latin1string::method);
@@ -211,11 +196,6 @@ RequestObject::RequestObject(NotificationObject notification_obj, QJsonValue id)
 
 RequestObject::RequestObject(JsonRpcObject obj) : NotificationObject(qMove(obj)) {}
 
-QJsonValue RequestObject::id() const
-{
-    return value(latin1string::id);
-}
-
 int RequestObject::checkIdField() const
 {
     QJsonValue const id_val = value(latin1string::id);
@@ -300,21 +280,6 @@ ErrorObject &ErrorObject::operator=(QJsonObject &&o) noexcept
     return *this;
 }
 
-int ErrorObject::code() const
-{
-    return value(latin1string::code).toInt();
-}
-
-QString ErrorObject::message() const
-{
-    return value(latin1string::message).toString();
-}
-
-QJsonValue ErrorObject::data() const
-{
-    return value(latin1string::data);
-}
-
 int ErrorObject::checkCodeField() const
 {
     QJsonValue const err_val = value(latin1string::code);
@@ -379,21 +344,6 @@ ResponseObject::ResponseObject(ErrorObject error, QJsonValue id) : JsonRpcObject
 
 ResponseObject::ResponseObject(JsonRpcObject obj) : JsonRpcObject(qMove(obj)) {}
 
-QJsonValue ResponseObject::id() const
-{
-    return value(latin1string::id);
-}
-
-QJsonValue ResponseObject::result() const
-{
-    return value(latin1string::result);
-}
-
-ErrorObject ResponseObject::error() const
-{
-    return ErrorObject(value(latin1string::error).toObject());
-}
-
 int ResponseObject::checkIdField() const
 {
     QJsonValue const id_val = value(latin1string::id);
@@ -472,83 +422,6 @@ bool ResponseObject::isValid() const
 }
 
 
-bool isJsonRpcFieldValid(QJsonObject const &jo)
-{
-    if (!JsonRpcObject::isJsonRpcFieldExists(jo) || !JsonRpcObject::isJsonRpcFieldIsString(jo))
-        return false;
-
-    return true;
-}
-
-bool isIdFieldValid(QJsonObject const &jo)
-{
-    QJsonValue const id_val = jo.value(latin1string::id);
-
-    if (!id_val.isString() && !id_val.isDouble())
-        return false;
-
-    if (id_val.isDouble()) {
-        double const d = id_val.toDouble();
-        if (!isInteger(d))
-            return false;
-    }
-
-    return true;
-}
-
-bool isNotificationMethodFieldValid(QJsonObject const &jo)
-{
-    QJsonValue const method_val = jo.value(latin1string::method);
-
-    if (!method_val.isString())
-        return false;
-
-    if (method_val.toString().startsWith(latin1string::rpc_dot))
-        return false;
-
-    return true;
-}
-
-bool isNorificationParamsFieldValid(QJsonObject const &jo)
-{
-    QJsonValue const params_val = jo.value(latin1string::params);
-
-    if (!params_val.isObject() && !params_val.isArray())
-        return false;
-
-    return true;
-}
-
-bool isRequestIdFieldValid(QJsonObject const &jo)
-{
-    return isIdFieldValid(jo);
-}
-
-bool isRequestMethodFieldValid(QJsonObject const &jo)
-{
-    return isNotificationMethodFieldValid(jo);
-}
-
-bool isRequestParamsFieldValid(QJsonObject const &jo)
-{
-    return isNorificationParamsFieldValid(jo);
-}
-
-bool isResponseIdFieldValid(QJsonObject const &jo)
-{
-    return isIdFieldValid(jo);
-}
-
-bool isResponseResultFieldValid(QJsonObject const &jo)
-{
-    QJsonValue const res_val = jo.value(latin1string::result);
-
-    if (res_val.isNull())
-        return false;
-
-    return true;
-}
-
 bool isResponseErrorFieldValid(QJsonObject const &jo)
 {
     auto const err_obj = ErrorObject(jo.value(latin1string::error).toObject());
@@ -629,6 +502,28 @@ bool isResponseObject(QJsonObject const &jo)
     return true;
 }
 
+
+QString idKey(QJsonValue const &id)
+{
+    switch (id.type()) {
+    case QJsonValue::String: return QLatin1Char('s') + id.toString();
+    case QJsonValue::Double: return QLatin1Char('n') + QString::number(id.toDouble(), 'g', 17);
+    default: return QString();
+    }
+}
+
+QByteArray callKey(QString const &method, QJsonValue const &params)
+{
+    QByteArray key = method.toUtf8();
+    key.append('\0');
+    switch (params.type()) {
+    case QJsonValue::Object: key.append(QJsonDocument(params.toObject()).toJson(QJsonDocument::Compact)); break;
+    case QJsonValue::Array: key.append(QJsonDocument(params.toArray()).toJson(QJsonDocument::Compact)); break;
+    default: break;
+    }
+    return key;
+}
+
 } // namespace _2_0
 
 } // namespace qjson
@@ -8,6 +8,7 @@
 #include <QLoggingCategory>
 #include <QString>
 
+#include <cmath>
 #include <limits>
 
 namespace rpc {
@@ -33,6 +34,8 @@ constexpr char const *const error = "error";
 constexpr char const *const code = "code";
 constexpr char const *const message = "message";
 constexpr char const *const data = "data";
+constexpr char const *const rpc_cancel = "rpc.cancel";
+constexpr char const *const timeout = "timeout";
 
 } // namespace string
 
@@ -50,6 +53,8 @@ constexpr QLatin1String error(string::error, 5);
 constexpr QLatin1String code(string::code, 4);
 constexpr QLatin1String message(string::message, 7);
 constexpr QLatin1String data(string::data, 4);
+constexpr QLatin1String rpc_cancel(string::rpc_cancel, 10);
+constexpr QLatin1String timeout(string::timeout, 7);
 
 } // namespace latin1string
 
@@ -93,16 +98,43 @@ constexpr int const error_type_size[ error_type_amount ] = {
 };
 
 
-enum class LIBQJSONRPC_EXPORT TransportError : int {};
+enum class LIBQJSONRPC_EXPORT ServerExtendedError : int {
+    Overloaded,
+    Cancelled,
+    DeadlineExceeded
+};
+Q_ENUM_NS(ServerExtendedError)
+
+constexpr char const *server_extended_error_string[ error_type_size[ ServerExtended ] ] = {
+    "server is overloaded, request rejected", "request was cancelled", "request deadline exceeded"
+};
+
+
+enum class LIBQJSONRPC_EXPORT TransportError : int {
+    FrameInvalid,
+    DecompressionFailed,
+    ConnectionLost,
+    NotConnected,
+    ResponseTimeout
+};
 Q_ENUM_NS(TransportError)
 
-constexpr char const *transport_error_string[ error_type_size[ Transport ] ] = {};
+constexpr char const *transport_error_string[ error_type_size[ Transport ] ] = {
+    "frame is invalid", "frame decompression failed", "connection is lost", "no connection is available",
+    "no response in time"
+};
 
 
-enum class LIBQJSONRPC_EXPORT SystemError : int {};
+enum class LIBQJSONRPC_EXPORT SystemError : int {
+    SharedMemoryUnavailable,
+    IoUringUnavailable,
+    ListenFailed
+};
 Q_ENUM_NS(SystemError)
 
-constexpr char const *system_error_string[ error_type_size[ System ] ] = {};
+constexpr char const *system_error_string[ error_type_size[ System ] ] = {
+    "shared memory is unavailable", "io_uring is unavailable", "listening socket setup failed"
+};
 
 
 enum class LIBQJSONRPC_EXPORT ApplicationError : int {
@@ -173,6 +205,11 @@ constexpr char const *parse_error_string[ error_type_size[ Parse ] ] = {
 [[nodiscard]] ParseError parseError(QJsonParseError je);
 
 
+[[nodiscard]] inline constexpr int errorCode(ServerExtendedError e)
+{
+    return -error_type_offset[ ServerExtended ] - static_cast<int>(e);
+};
+
 [[nodiscard]] inline constexpr int errorCode(TransportError e)
 {
     return -error_type_offset[ Transport ] - static_cast<int>(e);
@@ -221,14 +258,19 @@ constexpr char const *parse_error_string[ error_type_size[ Parse ] ] = {
 {
     Q_ASSERT(code < 0);
     switch (int err_id = -1; errorType(code)) {
+    case ServerExtended:
+        err_id = -code - error_type_offset[ ServerExtended ];
+        if (error_type_size[ ServerExtended ] <= err_id || !server_extended_error_string[ err_id ])
+            return string::error_unspecified;
+        return server_extended_error_string[ err_id ];
     case Transport:
         err_id = -code - error_type_offset[ Transport ];
-        if (error_type_size[ Transport ] <= err_id)
+        if (error_type_size[ Transport ] <= err_id || !transport_error_string[ err_id ])
             return string::error_unspecified;
         return transport_error_string[ err_id ];
     case System:
         err_id = -code - error_type_offset[ System ];
-        if (error_type_size[ System ] <= err_id)
+        if (error_type_size[ System ] <= err_id || !system_error_string[ err_id ])
             return string::error_unspecified;
         return system_error_string[ err_id ];
     case Application:
@@ -250,6 +292,14 @@ constexpr char const *parse_error_string[ error_type_size[ Parse ] ] = {
     }
 };
 
+// NOTE: json number without fractional part, as ids and error codes should be; inline in every build
+[[nodiscard]] inline bool isInteger(double d)
+{
+    double const i = std::trunc(d);
+    double const fract = d > .0 ? d - i : d + i;
+    return qIsNull(fract);
+}
+
 
 class LIBQJSONRPC_EXPORT JsonRpcObject : public QJsonObject
 {
@@ -390,8 +440,9 @@ public:
 
 
 // NOTE: if some field must not exists in valid state, you should check existens separatly
-[[nodiscard]] LIBQJSONRPC_EXPORT bool isJsonRpcFieldValid(QJsonObject const &jo);
 [[nodiscard]] LIBQJSONRPC_EXPORT bool isIdFieldValid(QJsonObject const &jo);
+[[nodiscard]] LIBQJSONRPC_EXPORT bool isResponseErrorFieldValid(QJsonObject const &jo);
+[[nodiscard]] LIBQJSONRPC_EXPORT bool isJsonRpcFieldValid(QJsonObject const &jo);
 [[nodiscard]] LIBQJSONRPC_EXPORT bool isNotificationMethodFieldValid(QJsonObject const &jo);
 [[nodiscard]] LIBQJSONRPC_EXPORT bool isNorificationParamsFieldValid(QJsonObject const &jo);
 [[nodiscard]] LIBQJSONRPC_EXPORT bool isRequestIdFieldValid(QJsonObject const &jo);
@@ -399,8 +450,6 @@ public:
 [[nodiscard]] LIBQJSONRPC_EXPORT bool isRequestParamsFieldValid(QJsonObject const &jo);
 [[nodiscard]] LIBQJSONRPC_EXPORT bool isResponseIdFieldValid(QJsonObject const &jo);
 [[nodiscard]] LIBQJSONRPC_EXPORT bool isResponseResultFieldValid(QJsonObject const &jo);
-[[nodiscard]] LIBQJSONRPC_EXPORT bool isResponseErrorFieldValid(QJsonObject const &jo);
-
 
 [[nodiscard]] LIBQJSONRPC_EXPORT bool isJsonRpcObject(QJsonObject const &jo);
 [[nodiscard]] LIBQJSONRPC_EXPORT bool isNotificationObject(QJsonObject const &jo);
@@ -408,7 +457,22 @@ public:
 [[nodiscard]] LIBQJSONRPC_EXPORT bool isResponseObject(QJsonObject const &jo);
 
 
+// NOTE: string and number ids never collide, suitable as hash key for request/response matching
+[[nodiscard]] LIBQJSONRPC_EXPORT QString idKey(QJsonValue const &id);
+
+// NOTE: canonical form of the call (QJsonObject keeps keys sorted), equal calls give equal keys
+[[nodiscard]] LIBQJSONRPC_EXPORT QByteArray callKey(QString const &method, QJsonValue const &params);
+
+
 } // namespace _2_0
 
 } // namespace qjson
 } // namespace rpc
+
+
+// NOTE: files of the shared library itself see declarations only, the exported definitions are in qjson-rpc.cpp
+#if !defined(QJSONRPC_LIBRARY) || defined(QJSONRPC_STATIC)
+#define QJSONRPC_INLINE inline
+#include <qjsonrpc/qjson-rpc-inline.hpp>
+#undef QJSONRPC_INLINE
+#endif
@@ -2,7 +2,9 @@
 
 #include <QtCore/qglobal.h>
 
-#if defined(QJSONRPC_LIBRARY)
+#if defined(QJSONRPC_STATIC)
+#  define LIBQJSONRPC_EXPORT
+#elif defined(QJSONRPC_LIBRARY)
 #  define LIBQJSONRPC_EXPORT Q_DECL_EXPORT
 #else
 #  define LIBQJSONRPC_EXPORT Q_DECL_IMPORT
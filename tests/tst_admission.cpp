@@ -0,0 +1,197 @@
+#include <qjsonrpc/qjson-rpc-admission.hpp>
+#include <qjsonrpc/qjson-rpc-dispatcher.hpp>
+
+#include <QJsonDocument>
+#include <QMutex>
+#include <QSemaphore>
+#include <QThread>
+#include <QThreadPool>
+#include <QtTest>
+
+using namespace rpc::qjson;
+
+
+namespace {
+
+int const overloaded = errorCode(ServerExtendedError::Overloaded);
+
+// runs every task left, returns their labels in order
+[[nodiscard]] QStringList drain(AdmissionController &controller, QStringList &log)
+{
+    AdmissionController::Task task;
+    while (controller.dequeue(task))
+        task();
+    return log;
+}
+
+[[nodiscard]] AdmissionController::Task label(QStringList &log, QString name)
+{
+    return [&log, name] { log.append(name); };
+}
+
+} // namespace
+
+
+class AdmissionTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void priorityOrder();
+    void queueLimit();
+    void belowTargetNotShed();
+    void shedStandingQueue();
+    void dispatcherOverloaded();
+};
+
+
+void AdmissionTest::priorityOrder()
+{
+    AdmissionController controller(3);
+    controller.setPriority(QStringLiteral("high"), 0);
+    controller.setPriority(QStringLiteral("mid"), 1);
+    QCOMPARE(controller.priority(QStringLiteral("other")), 2);
+
+    QStringList log;
+    QCOMPARE(controller.enqueue(QStringLiteral("other"), label(log, QStringLiteral("o1")), {}), 0);
+    QCOMPARE(controller.enqueue(QStringLiteral("mid"), label(log, QStringLiteral("m1")), {}), 0);
+    QCOMPARE(controller.enqueue(QStringLiteral("high"), label(log, QStringLiteral("h1")), {}), 0);
+    QCOMPARE(controller.enqueue(QStringLiteral("other"), label(log, QStringLiteral("o2")), {}), 0);
+    QCOMPARE(controller.enqueue(QStringLiteral("high"), label(log, QStringLiteral("h2")), {}), 0);
+    QCOMPARE(controller.stats().queued, 5);
+
+    // highest priority first, fifo within one
+    QCOMPARE(drain(controller, log),
+             (QStringList{ QStringLiteral("h1"), QStringLiteral("h2"), QStringLiteral("m1"), QStringLiteral("o1"),
+                           QStringLiteral("o2") }));
+    QCOMPARE(controller.stats().queued, 0);
+    QCOMPARE(controller.stats().admitted, quint64(5));
+}
+
+void AdmissionTest::queueLimit()
+{
+    AdmissionController controller(2, 2);
+    controller.setPriority(QStringLiteral("high"), 0);
+    controller.setQueueLimit(0, 1);
+    QCOMPARE(controller.queueLimit(0), 1);
+    QCOMPARE(controller.queueLimit(1), 2);
+
+    bool rejected = false;
+    auto const reject = [&rejected](int) { rejected = true; };
+    QCOMPARE(controller.enqueue(QStringLiteral("high"), {}, reject), 0);
+    QCOMPARE(controller.enqueue(QStringLiteral("high"), {}, reject), overloaded);
+
+    // other priority has its own limit
+    QCOMPARE(controller.enqueue(QStringLiteral("low"), {}, reject), 0);
+    QCOMPARE(controller.enqueue(QStringLiteral("low"), {}, reject), 0);
+    QCOMPARE(controller.enqueue(QStringLiteral("low"), {}, reject), overloaded);
+
+    // code is returned, reject is not called
+    QVERIFY(!rejected);
+    AdmissionController::Stats const stats = controller.stats();
+    QCOMPARE(stats.admitted, quint64(3));
+    QCOMPARE(stats.rejected, quint64(2));
+    QCOMPARE(stats.queued, 3);
+}
+
+void AdmissionTest::belowTargetNotShed()
+{
+    AdmissionController controller(1);
+    controller.setTarget(std::chrono::seconds(10));
+    controller.setInterval(std::chrono::milliseconds(1));
+
+    QStringList log;
+    for (int i = 0; i < 10; ++i)
+        QCOMPARE(controller.enqueue(QString(), label(log, QString::number(i)), {}), 0);
+    QThread::msleep(5);
+
+    QCOMPARE(drain(controller, log).size(), 10);
+    QCOMPARE(controller.stats().shed, quint64(0));
+}
+
+void AdmissionTest::shedStandingQueue()
+{
+    AdmissionController controller(1);
+    controller.setTarget(std::chrono::milliseconds(1));
+    controller.setInterval(std::chrono::milliseconds(20));
+
+    QStringList log;
+    QList<int> rejections;
+    auto const reject = [&rejections](int code) { rejections.append(code); };
+    for (int i = 0; i < 4; ++i)
+        QCOMPARE(controller.enqueue(QString(), label(log, QString::number(i)), reject), 0);
+    QThread::msleep(5);
+
+    // above target for less than interval, nothing is shed yet
+    AdmissionController::Task task;
+    QVERIFY(controller.dequeue(task));
+    task();
+    QCOMPARE(controller.stats().shed, quint64(0));
+
+    // standing above target for the whole interval, one is shed and the next one runs
+    QThread::msleep(30);
+    QVERIFY(controller.dequeue(task));
+    task();
+    QCOMPARE(log, (QStringList{ QStringLiteral("0"), QStringLiteral("2") }));
+    QCOMPARE(rejections, QList<int>{ overloaded });
+    QCOMPARE(controller.stats().shed, quint64(1));
+
+    // last item leaves an empty queue, it is never shed
+    QVERIFY(controller.dequeue(task));
+    task();
+    QCOMPARE(controller.stats().shed, quint64(1));
+    QVERIFY(!controller.dequeue(task));
+}
+
+void AdmissionTest::dispatcherOverloaded()
+{
+    Dispatcher dispatcher;
+    AdmissionController controller(1, 1);
+    QThreadPool pool;
+    pool.setMaxThreadCount(1);
+    dispatcher.setThreadPool(&pool);
+    dispatcher.setAdmissionController(&controller);
+
+    QSemaphore started;
+    QSemaphore proceed;
+    dispatcher.addMethod(QStringLiteral("block"), [&started, &proceed](RequestObject const &request) {
+        started.release();
+        proceed.acquire();
+        return ResponseObject(request.id(), true);
+    });
+
+    QMutex mutex;
+    QHash<int, QJsonObject> responses;
+    auto const collect = [&mutex, &responses](QByteArray const &response) {
+        QJsonObject const object = QJsonDocument::fromJson(response).object();
+        QMutexLocker locker(&mutex);
+        responses.insert(object.value(QStringLiteral("id")).toInt(), object);
+    };
+    auto const call = [](int id) {
+        return QJsonObject{ { QStringLiteral("jsonrpc"), QStringLiteral("2.0") },
+                            { QStringLiteral("method"), QStringLiteral("block") },
+                            { QStringLiteral("id"), id } };
+    };
+
+    // first one holds the only worker, second one waits in queue, third one does not fit
+    dispatcher.invoke(call(1), collect);
+    started.acquire();
+    dispatcher.invoke(call(2), collect);
+    dispatcher.invoke(call(3), collect);
+    {
+        QMutexLocker locker(&mutex);
+        QCOMPARE(responses.size(), 1);
+        QCOMPARE(responses.value(3).value(QStringLiteral("error")).toObject().value(QStringLiteral("code")).toInt(),
+                 overloaded);
+    }
+
+    proceed.release(2);
+    QVERIFY(pool.waitForDone());
+    QCOMPARE(responses.size(), 3);
+    QVERIFY(responses.value(1).value(QStringLiteral("result")).toBool());
+    QVERIFY(responses.value(2).value(QStringLiteral("result")).toBool());
+}
+
+QTEST_APPLESS_MAIN(AdmissionTest)
+
+#include "tst_admission.moc"
@@ -0,0 +1,262 @@
+#include <qjsonrpc/qjson-rpc-batcher.hpp>
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QtTest>
+
+using namespace rpc::qjson;
+
+
+namespace {
+
+constexpr int const frame_error = -32600;
+
+// collects responses by id
+struct Responses
+{
+    QHash<int, QJsonObject> by_id;
+
+    [[nodiscard]] CallBatcher::Callback callback(int id)
+    {
+        return [this, id](ResponseObject const &response) { by_id.insert(id, response); };
+    }
+
+    [[nodiscard]] ResponseObject value(int id) const { return ResponseObject(JsonRpcObject(by_id.value(id))); }
+};
+
+// NOTE: ResponseObject is not a registered metatype, so no QSignalSpy
+[[nodiscard]] QSharedPointer<int> countUnmatched(CallBatcher &batcher)
+{
+    auto count = QSharedPointer<int>::create(0);
+    QObject::connect(&batcher, &CallBatcher::unmatchedResponse, [count] { ++*count; });
+    return count;
+}
+
+[[nodiscard]] RequestObject request(int id)
+{
+    return RequestObject(QStringLiteral("m"), id);
+}
+
+[[nodiscard]] QByteArray result(int id)
+{
+    return "{\"jsonrpc\":\"2.0\",\"result\":" + QByteArray::number(id) + ",\"id\":" + QByteArray::number(id) + '}';
+}
+
+[[nodiscard]] QByteArray nullIdError()
+{
+    return "{\"jsonrpc\":\"2.0\",\"error\":{\"code\":" + QByteArray::number(frame_error) +
+           ",\"message\":\"invalid\"},\"id\":null}";
+}
+
+} // namespace
+
+
+class BatcherTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void coalesce();
+    void single();
+    void maxBatchSize();
+    void route();
+    void invalidResponse();
+    void frameErrorInBatch();
+    void frameErrorSoleFrame();
+    void frameErrorAmbiguous();
+    void failPending();
+};
+
+
+void BatcherTest::coalesce()
+{
+    CallBatcher batcher;
+    QSignalSpy frames(&batcher, &CallBatcher::frameReady);
+    Responses responses;
+
+    batcher.call(request(1), responses.callback(1));
+    batcher.notify(NotificationObject(QStringLiteral("n")));
+    batcher.call(request(2), responses.callback(2));
+    QCOMPARE(batcher.queuedCount(), 3);
+    QCOMPARE(frames.count(), 0);
+
+    // next event loop turn
+    QTRY_COMPARE(frames.count(), 1);
+    QCOMPARE(batcher.queuedCount(), 0);
+    QCOMPARE(batcher.awaitingCount(), 2);
+
+    QJsonArray const batch = QJsonDocument::fromJson(frames.first().first().toByteArray()).array();
+    QCOMPARE(batch.size(), 3);
+    QCOMPARE(batch.at(0).toObject().value(QStringLiteral("id")).toInt(), 1);
+    QVERIFY(!batch.at(1).toObject().contains(QStringLiteral("id")));
+    QCOMPARE(batch.at(2).toObject().value(QStringLiteral("id")).toInt(), 2);
+}
+
+void BatcherTest::single()
+{
+    CallBatcher batcher;
+    QSignalSpy frames(&batcher, &CallBatcher::frameReady);
+
+    batcher.call(request(1), {});
+    batcher.flush();
+    QCOMPARE(frames.count(), 1);
+    QVERIFY(QJsonDocument::fromJson(frames.first().first().toByteArray()).isObject());
+
+    // nothing queued, nothing sent
+    batcher.flush();
+    QCOMPARE(frames.count(), 1);
+}
+
+void BatcherTest::maxBatchSize()
+{
+    CallBatcher batcher;
+    batcher.setMaxBatchSize(2);
+    QSignalSpy frames(&batcher, &CallBatcher::frameReady);
+
+    batcher.call(request(1), {});
+    QCOMPARE(frames.count(), 0);
+    batcher.call(request(2), {});
+    QCOMPARE(frames.count(), 1);
+    QCOMPARE(QJsonDocument::fromJson(frames.first().first().toByteArray()).array().size(), 2);
+
+    batcher.call(request(3), {});
+    batcher.call(request(4), {});
+    batcher.call(request(5), {});
+    QCOMPARE(frames.count(), 2);
+    QCOMPARE(batcher.queuedCount(), 1);
+}
+
+void BatcherTest::route()
+{
+    CallBatcher batcher;
+    auto const unmatched = countUnmatched(batcher);
+    Responses responses;
+
+    batcher.call(request(1), responses.callback(1));
+    batcher.call(request(2), responses.callback(2));
+    batcher.flush();
+
+    // any order, unknown id goes to unmatchedResponse
+    QCOMPARE(batcher.handleResponse('[' + result(2) + ',' + result(7) + ',' + result(1) + ']'), 0);
+    QCOMPARE(responses.by_id.size(), 2);
+    QCOMPARE(responses.value(1).result().toInt(), 1);
+    QCOMPARE(responses.value(2).result().toInt(), 2);
+    QCOMPARE(*unmatched, 1);
+    QCOMPARE(batcher.awaitingCount(), 0);
+
+    // answered once only
+    QCOMPARE(batcher.handleResponse(result(1)), 0);
+    QCOMPARE(*unmatched, 2);
+}
+
+void BatcherTest::invalidResponse()
+{
+    CallBatcher batcher;
+    QVERIFY(batcher.handleResponse(QByteArrayLiteral("{")) != 0);
+    QCOMPARE(batcher.handleResponse(QByteArrayLiteral("[]")), errorCode(ApplicationError::ResponseInvalid));
+
+    // valid elements are still routed
+    Responses responses;
+    batcher.call(request(1), responses.callback(1));
+    batcher.flush();
+    QCOMPARE(batcher.handleResponse("[1," + result(1) + ']'), errorCode(ApplicationError::ResponseInvalid));
+    QVERIFY(responses.by_id.contains(1));
+}
+
+void BatcherTest::frameErrorInBatch()
+{
+    CallBatcher batcher;
+    auto const unmatched = countUnmatched(batcher);
+    Responses responses;
+
+    batcher.call(request(1), responses.callback(1));
+    batcher.call(request(2), responses.callback(2));
+    batcher.flush();
+    batcher.call(request(3), responses.callback(3));
+    batcher.flush();
+
+    // error belongs to the frame of the other responses, later frame is not touched
+    QCOMPARE(batcher.handleResponse('[' + result(1) + ',' + nullIdError() + ']'), 0);
+    QCOMPARE(responses.value(1).result().toInt(), 1);
+    QCOMPARE(responses.value(2).error().code(), frame_error);
+    QCOMPARE(responses.value(2).id().toInt(), 2);
+    QVERIFY(!responses.by_id.contains(3));
+    QCOMPARE(batcher.awaitingCount(), 1);
+    QCOMPARE(*unmatched, 0);
+}
+
+void BatcherTest::frameErrorSoleFrame()
+{
+    CallBatcher batcher;
+    auto const unmatched = countUnmatched(batcher);
+    Responses responses;
+
+    batcher.call(request(1), responses.callback(1));
+    batcher.call(request(2), responses.callback(2));
+    batcher.flush();
+
+    // whole frame is rejected
+    QCOMPARE(batcher.handleResponse(nullIdError()), 0);
+    QCOMPARE(responses.by_id.size(), 2);
+    QCOMPARE(responses.value(1).error().code(), frame_error);
+    QCOMPARE(responses.value(2).error().code(), frame_error);
+    QCOMPARE(batcher.awaitingCount(), 0);
+    QCOMPARE(*unmatched, 0);
+}
+
+void BatcherTest::frameErrorAmbiguous()
+{
+    CallBatcher batcher;
+    auto const unmatched = countUnmatched(batcher);
+    Responses responses;
+
+    batcher.call(request(1), responses.callback(1));
+    batcher.flush();
+    batcher.call(request(2), responses.callback(2));
+    batcher.flush();
+
+    // either frame may be the failed one
+    QCOMPARE(batcher.handleResponse(nullIdError()), 0);
+    QCOMPARE(*unmatched, 1);
+    QVERIFY(responses.by_id.isEmpty());
+    QCOMPARE(batcher.awaitingCount(), 2);
+
+    // batch of errors only is not tied either
+    QCOMPARE(batcher.handleResponse('[' + nullIdError() + ',' + nullIdError() + ']'), 0);
+    QCOMPARE(*unmatched, 3);
+    QCOMPARE(batcher.awaitingCount(), 2);
+
+    // once the other frame is answered, the error is tied to the one left
+    QCOMPARE(batcher.handleResponse(result(1)), 0);
+    QCOMPARE(batcher.handleResponse(nullIdError()), 0);
+    QCOMPARE(responses.value(2).error().code(), frame_error);
+    QCOMPARE(*unmatched, 3);
+}
+
+void BatcherTest::failPending()
+{
+    CallBatcher batcher;
+    QSignalSpy frames(&batcher, &CallBatcher::frameReady);
+    Responses responses;
+
+    batcher.call(request(1), responses.callback(1));
+    batcher.flush();
+    batcher.call(request(2), responses.callback(2));
+    batcher.notify(NotificationObject(QStringLiteral("n")));
+
+    batcher.failPending(ErrorObject(errorCode(TransportError::ConnectionLost)));
+    QCOMPARE(responses.by_id.size(), 2);
+    QCOMPARE(responses.value(1).error().code(), errorCode(TransportError::ConnectionLost));
+    QCOMPARE(responses.value(2).error().code(), errorCode(TransportError::ConnectionLost));
+    QCOMPARE(responses.value(2).id().toInt(), 2);
+    QCOMPARE(batcher.queuedCount(), 0);
+    QCOMPARE(batcher.awaitingCount(), 0);
+
+    // queued messages are dropped, not sent later
+    QTest::qWait(10);
+    QCOMPARE(frames.count(), 1);
+}
+
+QTEST_GUILESS_MAIN(BatcherTest)
+
+#include "tst_batcher.moc"
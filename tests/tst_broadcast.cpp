@@ -0,0 +1,225 @@
+#include <qjsonrpc/qjson-rpc-broadcast.hpp>
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QtTest>
+
+using namespace rpc::qjson;
+
+
+namespace {
+
+// keeps written bytes pending until flushed, like a socket with a full send buffer
+class Device : public QIODevice
+{
+public:
+    Device() { open(QIODevice::WriteOnly); }
+
+    bool isSequential() const override { return true; }
+    qint64 bytesToWrite() const override { return m_pending.size(); }
+
+    void flushAll()
+    {
+        qint64 const size = m_pending.size();
+        written += m_pending;
+        m_pending.clear();
+        emit bytesWritten(size);
+    }
+
+    QByteArray written;
+
+protected:
+    qint64 readData(char *, qint64) override { return -1; }
+    qint64 writeData(char const *data, qint64 size) override
+    {
+        m_pending.append(data, static_cast<int>(size));
+        return size;
+    }
+
+private:
+    QByteArray m_pending;
+};
+
+QString const topic = QStringLiteral("t");
+QString const other_topic = QStringLiteral("o");
+
+} // namespace
+
+
+class BroadcastTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void noSubscribers();
+    void fanOut();
+    void publishSerialized();
+    void coalesce();
+    void coalesceOverflow();
+    void drop();
+    void unsubscribe();
+    void destroyedDevice();
+};
+
+
+void BroadcastTest::noSubscribers()
+{
+    Broadcaster broadcaster;
+    QCOMPARE(broadcaster.publishRaw(topic, QByteArrayLiteral("a")), 0);
+    QCOMPARE(broadcaster.publish(topic, NotificationObject(QStringLiteral("n"))), 0);
+    QCOMPARE(broadcaster.stats().published, quint64(0));
+}
+
+void BroadcastTest::fanOut()
+{
+    Broadcaster broadcaster;
+    Device first;
+    Device second;
+    broadcaster.subscribe(topic, &first);
+    broadcaster.subscribe(topic, &first);
+    broadcaster.subscribe(topic, &second);
+    broadcaster.subscribe(other_topic, &second);
+    QCOMPARE(broadcaster.subscriberCount(topic), 2);
+
+    QCOMPARE(broadcaster.publishRaw(topic, QByteArrayLiteral("a")), 2);
+    QCOMPARE(broadcaster.publishRaw(other_topic, QByteArrayLiteral("b")), 1);
+    first.flushAll();
+    second.flushAll();
+    QCOMPARE(first.written, QByteArrayLiteral("a"));
+    QCOMPARE(second.written, QByteArrayLiteral("ab"));
+
+    Broadcaster::Stats const stats = broadcaster.stats();
+    QCOMPARE(stats.published, quint64(2));
+    QCOMPARE(stats.delivered, quint64(3));
+}
+
+void BroadcastTest::publishSerialized()
+{
+    Broadcaster broadcaster;
+    Device device;
+    broadcaster.subscribe(topic, &device);
+
+    NotificationObject const notification(QStringLiteral("n"), QJsonArray{ 1 });
+    QCOMPARE(broadcaster.publish(topic, notification), 1);
+    device.flushAll();
+    QCOMPARE(QJsonDocument::fromJson(device.written).object(), static_cast<QJsonObject const &>(notification));
+}
+
+void BroadcastTest::coalesce()
+{
+    Broadcaster broadcaster;
+    broadcaster.setHighWatermark(1);
+    Device device;
+    broadcaster.subscribe(topic, &device);
+    broadcaster.subscribe(other_topic, &device);
+
+    // first goes out, the rest waits for the device to drain
+    QCOMPARE(broadcaster.publishRaw(topic, QByteArrayLiteral("a1")), 1);
+    QCOMPARE(broadcaster.publishRaw(topic, QByteArrayLiteral("a2")), 1);
+    QCOMPARE(broadcaster.publishRaw(other_topic, QByteArrayLiteral("b1")), 1);
+    QCOMPARE(broadcaster.publishRaw(topic, QByteArrayLiteral("a3")), 1);
+    QCOMPARE(broadcaster.pendingCount(&device), 2);
+
+    // newer notification of a topic replaces the queued one in place
+    device.flushAll();
+    QCOMPARE(device.written, QByteArrayLiteral("a1"));
+    QCOMPARE(broadcaster.pendingCount(&device), 1);
+    device.flushAll();
+    device.flushAll();
+    QCOMPARE(device.written, QByteArrayLiteral("a1a3b1"));
+    QCOMPARE(broadcaster.pendingCount(&device), 0);
+
+    Broadcaster::Stats const stats = broadcaster.stats();
+    QCOMPARE(stats.published, quint64(4));
+    QCOMPARE(stats.delivered, quint64(3));
+    QCOMPARE(stats.coalesced, quint64(1));
+    QCOMPARE(stats.dropped, quint64(0));
+}
+
+void BroadcastTest::coalesceOverflow()
+{
+    Broadcaster broadcaster;
+    broadcaster.setHighWatermark(1);
+    broadcaster.setMaxPending(1);
+    Device device;
+    broadcaster.subscribe(topic, &device);
+    broadcaster.subscribe(other_topic, &device);
+
+    QCOMPARE(broadcaster.publishRaw(topic, QByteArrayLiteral("a1")), 1);
+    QCOMPARE(broadcaster.publishRaw(topic, QByteArrayLiteral("a2")), 1);
+    // queue is full, the oldest one makes room
+    QCOMPARE(broadcaster.publishRaw(other_topic, QByteArrayLiteral("b1")), 1);
+    QCOMPARE(broadcaster.pendingCount(&device), 1);
+    QCOMPARE(broadcaster.stats().dropped, quint64(1));
+
+    device.flushAll();
+    device.flushAll();
+    QCOMPARE(device.written, QByteArrayLiteral("a1b1"));
+}
+
+void BroadcastTest::drop()
+{
+    Broadcaster broadcaster;
+    broadcaster.setOverflowPolicy(Broadcaster::OverflowPolicy::Drop);
+    broadcaster.setHighWatermark(1);
+    broadcaster.setMaxPending(1);
+    Device slow;
+    Device fast;
+    broadcaster.subscribe(topic, &slow);
+
+    QCOMPARE(broadcaster.publishRaw(topic, QByteArrayLiteral("a1")), 1);
+    QCOMPARE(broadcaster.publishRaw(topic, QByteArrayLiteral("a2")), 1);
+    // dropped subscriber is not counted, nor is the notification published
+    QCOMPARE(broadcaster.publishRaw(topic, QByteArrayLiteral("a3")), 0);
+    QCOMPARE(broadcaster.stats().published, quint64(2));
+    QCOMPARE(broadcaster.stats().dropped, quint64(1));
+
+    broadcaster.subscribe(topic, &fast);
+    QCOMPARE(broadcaster.publishRaw(topic, QByteArrayLiteral("a4")), 1);
+    QCOMPARE(broadcaster.stats().published, quint64(3));
+
+    slow.flushAll();
+    slow.flushAll();
+    QCOMPARE(slow.written, QByteArrayLiteral("a1a2"));
+    fast.flushAll();
+    QCOMPARE(fast.written, QByteArrayLiteral("a4"));
+}
+
+void BroadcastTest::unsubscribe()
+{
+    Broadcaster broadcaster;
+    broadcaster.setHighWatermark(1);
+    Device device;
+    broadcaster.subscribe(topic, &device);
+
+    QCOMPARE(broadcaster.publishRaw(topic, QByteArrayLiteral("a1")), 1);
+    QCOMPARE(broadcaster.publishRaw(topic, QByteArrayLiteral("a2")), 1);
+    broadcaster.unsubscribe(topic, &device);
+    QCOMPARE(broadcaster.subscriberCount(topic), 0);
+    QCOMPARE(broadcaster.publishRaw(topic, QByteArrayLiteral("a3")), 0);
+
+    // already queued one is still delivered
+    device.flushAll();
+    device.flushAll();
+    QCOMPARE(device.written, QByteArrayLiteral("a1a2"));
+    QCOMPARE(broadcaster.pendingCount(&device), 0);
+}
+
+void BroadcastTest::destroyedDevice()
+{
+    Broadcaster broadcaster;
+    broadcaster.setHighWatermark(1);
+    auto *const device = new Device;
+    broadcaster.subscribe(topic, device);
+    QCOMPARE(broadcaster.publishRaw(topic, QByteArrayLiteral("a1")), 1);
+    QCOMPARE(broadcaster.publishRaw(topic, QByteArrayLiteral("a2")), 1);
+
+    delete device;
+    QCOMPARE(broadcaster.subscriberCount(topic), 0);
+    QCOMPARE(broadcaster.stats().dropped, quint64(1));
+    QCOMPARE(broadcaster.publishRaw(topic, QByteArrayLiteral("a3")), 0);
+}
+
+QTEST_APPLESS_MAIN(BroadcastTest)
+
+#include "tst_broadcast.moc"
@@ -0,0 +1,185 @@
+#include <qjsonrpc/qjson-rpc-cache.hpp>
+#include <qjsonrpc/qjson-rpc-writer.hpp>
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QThread>
+#include <QtTest>
+
+using namespace rpc::qjson;
+
+
+namespace {
+
+QString const method = QStringLiteral("get");
+
+[[nodiscard]] RequestObject request(int param, int id = 1)
+{
+    return RequestObject(method, id, QJsonArray{ param });
+}
+
+[[nodiscard]] ResponseObject response(int param, int id = 1)
+{
+    return ResponseObject(QJsonValue(id), QStringLiteral("value %1").arg(param));
+}
+
+// bytes an entry of request(param) with response(param) is charged
+[[nodiscard]] int cost(int param)
+{
+    return callKey(method, QJsonArray{ param }).size() + toJson(response(param).result()).size();
+}
+
+} // namespace
+
+
+class CacheTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void hit();
+    void notCacheable();
+    void errorNotCached();
+    void evictLeastRecentlyUsed();
+    void replaceIsNotEviction();
+    void oversized();
+    void expiry();
+    void clear();
+};
+
+
+void CacheTest::hit()
+{
+    ResultCache cache;
+    cache.setCacheable(method, std::chrono::minutes(1), 1024);
+
+    QVERIFY(cache.lookup(request(1)).isNull());
+    cache.store(request(1), response(1));
+
+    // id of the request looking up, not of the stored one
+    QJsonObject const cached = QJsonDocument::fromJson(cache.lookup(request(1, 9))).object();
+    QCOMPARE(cached.value(QStringLiteral("id")).toInt(), 9);
+    QCOMPARE(cached.value(QStringLiteral("result")).toString(), QStringLiteral("value 1"));
+
+    // other params are another entry
+    QVERIFY(cache.lookup(request(2)).isNull());
+
+    ResultCache::Stats const stats = cache.stats(method);
+    QCOMPARE(stats.hits, quint64(1));
+    QCOMPARE(stats.misses, quint64(2));
+    QCOMPARE(stats.entries, 1);
+    QCOMPARE(stats.bytes, cost(1));
+}
+
+void CacheTest::notCacheable()
+{
+    ResultCache cache;
+    QVERIFY(!cache.isCacheable(method));
+    cache.store(request(1), response(1));
+    QVERIFY(cache.lookup(request(1)).isNull());
+    QCOMPARE(cache.stats().misses, quint64(0));
+
+    cache.setCacheable(method, std::chrono::minutes(1), 1024);
+    cache.store(request(1), response(1));
+    cache.setNotCacheable(method);
+    QVERIFY(!cache.isCacheable(method));
+    QVERIFY(cache.lookup(request(1)).isNull());
+    QCOMPARE(cache.stats().entries, 0);
+}
+
+void CacheTest::errorNotCached()
+{
+    ResultCache cache;
+    cache.setCacheable(method, std::chrono::minutes(1), 1024);
+    cache.store(request(1), ResponseObject(ErrorObject(errorCode(ServerError::Internal)), 1));
+    QVERIFY(cache.lookup(request(1)).isNull());
+    QCOMPARE(cache.stats(method).entries, 0);
+}
+
+void CacheTest::evictLeastRecentlyUsed()
+{
+    ResultCache cache;
+    // room for two entries, not three
+    cache.setCacheable(method, std::chrono::minutes(1), cost(1) + cost(2));
+
+    cache.store(request(1), response(1));
+    cache.store(request(2), response(2));
+    QCOMPARE(cache.stats(method).evictions, quint64(0));
+
+    // 1 is used more recently than 2
+    QVERIFY(!cache.lookup(request(1)).isNull());
+    cache.store(request(3), response(3));
+
+    ResultCache::Stats const stats = cache.stats(method);
+    QCOMPARE(stats.evictions, quint64(1));
+    QCOMPARE(stats.entries, 2);
+    QVERIFY(stats.bytes <= cost(1) + cost(2));
+
+    QVERIFY(cache.lookup(request(2)).isNull());
+    QVERIFY(!cache.lookup(request(1)).isNull());
+    QVERIFY(!cache.lookup(request(3)).isNull());
+}
+
+void CacheTest::replaceIsNotEviction()
+{
+    ResultCache cache;
+    cache.setCacheable(method, std::chrono::minutes(1), cost(1));
+
+    cache.store(request(1), response(1));
+    cache.store(request(1), response(1));
+
+    ResultCache::Stats const stats = cache.stats(method);
+    QCOMPARE(stats.evictions, quint64(0));
+    QCOMPARE(stats.entries, 1);
+}
+
+void CacheTest::oversized()
+{
+    ResultCache cache;
+    cache.setCacheable(method, std::chrono::minutes(1), cost(1));
+    cache.store(request(1), response(1));
+
+    // larger than the whole budget, not cached and nothing is evicted for it
+    RequestObject const large(method, 1, QJsonArray{ QString(cost(1), QLatin1Char('x')) });
+    cache.store(large, ResponseObject(QJsonValue(1), 1));
+    QVERIFY(cache.lookup(large).isNull());
+
+    ResultCache::Stats const stats = cache.stats(method);
+    QCOMPARE(stats.evictions, quint64(0));
+    QCOMPARE(stats.entries, 1);
+    QVERIFY(!cache.lookup(request(1)).isNull());
+}
+
+void CacheTest::expiry()
+{
+    ResultCache cache;
+    cache.setCacheable(method, std::chrono::milliseconds(1), 1024);
+    cache.store(request(1), response(1));
+    QThread::msleep(5);
+
+    QVERIFY(cache.lookup(request(1)).isNull());
+    ResultCache::Stats const stats = cache.stats(method);
+    QCOMPARE(stats.expirations, quint64(1));
+    QCOMPARE(stats.misses, quint64(1));
+    QCOMPARE(stats.entries, 0);
+}
+
+void CacheTest::clear()
+{
+    ResultCache cache;
+    cache.setCacheable(method, std::chrono::minutes(1), 1024);
+    cache.setCacheable(QStringLiteral("other"), std::chrono::minutes(1), 1024);
+    cache.store(request(1), response(1));
+    cache.store(RequestObject(QStringLiteral("other"), 1), response(1));
+    QCOMPARE(cache.stats().entries, 2);
+
+    cache.clear();
+    ResultCache::Stats const stats = cache.stats();
+    QCOMPARE(stats.entries, 0);
+    QCOMPARE(stats.bytes, 0);
+    QVERIFY(cache.isCacheable(method));
+}
+
+QTEST_APPLESS_MAIN(CacheTest)
+
+#include "tst_cache.moc"
@@ -0,0 +1,211 @@
+#include <qjsonrpc/qjson-rpc-cancel.hpp>
+#include <qjsonrpc/qjson-rpc-dispatcher.hpp>
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QSemaphore>
+#include <QThreadPool>
+#include <QtTest>
+
+using namespace rpc::qjson;
+
+
+namespace {
+
+int const cancelled = errorCode(ServerExtendedError::Cancelled);
+int const deadline_exceeded = errorCode(ServerExtendedError::DeadlineExceeded);
+
+void ignore(QByteArray const &) {}
+
+[[nodiscard]] QJsonObject call(QString const &method, int id)
+{
+    return RequestObject(method, id, QJsonArray());
+}
+
+} // namespace
+
+
+class CancelTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void token();
+    void notification_data();
+    void notification();
+    void cancelBySession();
+    void timeoutCappedByDefault();
+    void coalescedGroup();
+    void expiredInQueue();
+
+private:
+    Dispatcher *m_dispatcher = nullptr;
+    QList<ResponsePromise> m_promises;
+    QList<CancellationToken> m_tokens;
+};
+
+
+void CancelTest::init()
+{
+    // slow keeps its promise and token for the test to look at
+    m_dispatcher = new Dispatcher;
+    m_dispatcher->addAsyncMethod(QStringLiteral("slow"), [this](RequestObject const &, ResponsePromise promise,
+                                                                CancellationToken const &token) {
+        m_promises.append(promise);
+        m_tokens.append(token);
+    });
+}
+
+void CancelTest::cleanup()
+{
+    m_promises.clear();
+    m_tokens.clear();
+    delete m_dispatcher;
+    m_dispatcher = nullptr;
+}
+
+void CancelTest::token()
+{
+    CancellationToken token;
+    QVERIFY(!token.isCancelled());
+    QCOMPARE(token.remainingTime(), qint64(-1));
+    QCOMPARE(token.reason(), 0);
+
+    // copies share the state
+    CancellationToken const copy = token;
+    token.cancel();
+    QVERIFY(copy.isCancelled());
+    QCOMPARE(copy.reason(), cancelled);
+
+    CancellationToken expiring;
+    expiring.setDeadline(QDeadlineTimer(0));
+    QVERIFY(expiring.isExpired());
+    QVERIFY(expiring.isCancelled());
+    QCOMPARE(expiring.reason(), deadline_exceeded);
+}
+
+void CancelTest::notification_data()
+{
+    QTest::addColumn<QByteArray>("message");
+    QTest::addColumn<bool>("expected");
+
+    QTest::newRow("cancel") << QJsonDocument(cancelNotification(1)).toJson() << true;
+    QTest::newRow("deadline")
+        << QJsonDocument(deadlineNotification(QStringLiteral("a"), std::chrono::seconds(1))).toJson() << true;
+    QTest::newRow("zero timeout")
+        << QByteArrayLiteral(R"({"jsonrpc":"2.0","method":"rpc.cancel","params":{"id":1,"timeout":0}})") << true;
+
+    QTest::newRow("negative timeout")
+        << QByteArrayLiteral(R"({"jsonrpc":"2.0","method":"rpc.cancel","params":{"id":1,"timeout":-1}})") << false;
+    QTest::newRow("fractional timeout")
+        << QByteArrayLiteral(R"({"jsonrpc":"2.0","method":"rpc.cancel","params":{"id":1,"timeout":1.5}})") << false;
+    QTest::newRow("string timeout")
+        << QByteArrayLiteral(R"({"jsonrpc":"2.0","method":"rpc.cancel","params":{"id":1,"timeout":"10"}})") << false;
+    QTest::newRow("request") << QByteArrayLiteral(R"({"jsonrpc":"2.0","method":"rpc.cancel","params":{"id":1},"id":2})")
+                             << false;
+    QTest::newRow("no params") << QByteArrayLiteral(R"({"jsonrpc":"2.0","method":"rpc.cancel"})") << false;
+    QTest::newRow("no id") << QByteArrayLiteral(R"({"jsonrpc":"2.0","method":"rpc.cancel","params":{}})") << false;
+    QTest::newRow("other method") << QByteArrayLiteral(R"({"jsonrpc":"2.0","method":"cancel","params":{"id":1}})")
+                                  << false;
+}
+
+void CancelTest::notification()
+{
+    QFETCH(QByteArray, message);
+    QFETCH(bool, expected);
+
+    QCOMPARE(isCancelNotification(QJsonDocument::fromJson(message).object()), expected);
+}
+
+void CancelTest::cancelBySession()
+{
+    QObject session;
+    QObject other;
+    m_dispatcher->invoke(call(QStringLiteral("slow"), 1), ignore, &session);
+    QCOMPARE(m_tokens.size(), 1);
+
+    // ids are scoped by session, unknown ids are ignored
+    m_dispatcher->invoke(cancelNotification(1), ignore, &other);
+    m_dispatcher->invoke(cancelNotification(7), ignore, &session);
+    QVERIFY(!m_tokens.first().isCancelled());
+
+    m_dispatcher->invoke(cancelNotification(1), ignore, &session);
+    QCOMPARE(m_tokens.first().reason(), cancelled);
+}
+
+void CancelTest::timeoutCappedByDefault()
+{
+    m_dispatcher->setDefaultTimeout(std::chrono::seconds(10));
+    m_dispatcher->invoke(call(QStringLiteral("slow"), 1), ignore);
+    m_dispatcher->invoke(call(QStringLiteral("slow"), 2), ignore);
+    QVERIFY(m_tokens.first().remainingTime() <= 10'000);
+
+    // shorter one is taken, longer one does not lift the default
+    m_dispatcher->invoke(deadlineNotification(1, std::chrono::milliseconds(500)), ignore);
+    m_dispatcher->invoke(deadlineNotification(2, std::chrono::hours(1)), ignore);
+    QVERIFY(m_tokens.at(0).remainingTime() <= 500);
+    QVERIFY(m_tokens.at(1).remainingTime() <= 10'000);
+    QVERIFY(!m_tokens.at(1).isCancelled());
+
+    // zero timeout expires at once
+    m_dispatcher->invoke(deadlineNotification(2, std::chrono::milliseconds(0)), ignore);
+    QCOMPARE(m_tokens.at(1).reason(), deadline_exceeded);
+}
+
+void CancelTest::coalescedGroup()
+{
+    m_dispatcher->setCoalescing(true);
+    QList<QByteArray> responses;
+    auto const collect = [&responses](QByteArray const &response) { responses.append(response); };
+
+    m_dispatcher->invoke(call(QStringLiteral("slow"), 1), collect);
+    m_dispatcher->invoke(call(QStringLiteral("slow"), 2), collect);
+    QCOMPARE(m_tokens.size(), 1);
+    CancellationToken const execution = m_tokens.first();
+
+    // execution goes on while any caller waits for it
+    m_dispatcher->invoke(cancelNotification(1), ignore);
+    QVERIFY(!execution.isCancelled());
+    m_dispatcher->invoke(cancelNotification(2), ignore);
+    QCOMPARE(execution.reason(), cancelled);
+
+    // callers are still answered by whatever the handler settles with
+    m_promises.first().reject(ErrorObject(cancelled));
+    QCOMPARE(responses.size(), 2);
+}
+
+void CancelTest::expiredInQueue()
+{
+    QThreadPool pool;
+    pool.setMaxThreadCount(1);
+    m_dispatcher->setThreadPool(&pool);
+
+    QSemaphore started;
+    QSemaphore proceed;
+    m_dispatcher->addMethod(QStringLiteral("block"), [&started, &proceed](RequestObject const &request) {
+        started.release();
+        proceed.acquire();
+        return ResponseObject(request.id(), true);
+    });
+
+    QByteArray response;
+    m_dispatcher->invoke(call(QStringLiteral("block"), 1), ignore);
+    started.acquire();
+    m_dispatcher->invoke(call(QStringLiteral("block"), 2), [&response](QByteArray const &r) { response = r; });
+    m_dispatcher->invoke(deadlineNotification(2, std::chrono::milliseconds(0)), ignore);
+
+    // expired before a worker picks it, handler is not run
+    proceed.release();
+    QVERIFY(pool.waitForDone());
+    QCOMPARE(started.available(), 0);
+    QJsonObject const error = QJsonDocument::fromJson(response).object().value(QStringLiteral("error")).toObject();
+    QCOMPARE(error.value(QStringLiteral("code")).toInt(), deadline_exceeded);
+    m_dispatcher->setThreadPool(nullptr);
+}
+
+QTEST_APPLESS_MAIN(CancelTest)
+
+#include "tst_cancel.moc"
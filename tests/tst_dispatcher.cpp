@@ -0,0 +1,188 @@
+#include <qjsonrpc/qjson-rpc-dispatcher.hpp>
+
+#include <QBuffer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QtTest>
+
+using namespace rpc::qjson;
+
+
+namespace {
+
+[[nodiscard]] QByteArray request(QByteArray const &method, int id)
+{
+    return "{\"jsonrpc\":\"2.0\",\"method\":\"" + method + "\",\"params\":[" + QByteArray::number(id) +
+           "],\"id\":" + QByteArray::number(id) + '}';
+}
+
+[[nodiscard]] QByteArray notification(QByteArray const &method)
+{
+    return "{\"jsonrpc\":\"2.0\",\"method\":\"" + method + "\"}";
+}
+
+// ids of the batch response, error code instead of id for errors without one
+[[nodiscard]] QList<int> ids(QByteArray const &response)
+{
+    QList<int> result;
+    for (QJsonValue const &value : QJsonDocument::fromJson(response).array()) {
+        QJsonObject const object = value.toObject();
+        result.append(object.value(QStringLiteral("id")).isNull()
+                          ? object.value(QStringLiteral("error")).toObject().value(QStringLiteral("code")).toInt()
+                          : object.value(QStringLiteral("id")).toInt());
+    }
+    return result;
+}
+
+} // namespace
+
+
+class DispatcherTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void single();
+    void singleNotification();
+    void invalidMessage_data();
+    void invalidMessage();
+    void batch();
+    void batchOfNotifications();
+    void batchCollected();
+    void batchStreaming();
+    void heldWhileStreaming();
+
+private:
+    Dispatcher m_dispatcher;
+    QBuffer m_device;
+    QList<ResponsePromise> m_promises;
+};
+
+
+void DispatcherTest::init()
+{
+    // echo answers with its first param, slow is answered once the test settles its promise
+    m_dispatcher.addMethod(QStringLiteral("echo"), [](RequestObject const &request) {
+        return ResponseObject(request.id(), request.params().toArray().first());
+    });
+    m_dispatcher.addAsyncMethod(QStringLiteral("slow"),
+                                [this](RequestObject const &, ResponsePromise promise, CancellationToken const &) {
+                                    m_promises.append(promise);
+                                });
+    m_dispatcher.setBatchStreaming(false);
+
+    m_device.setData(QByteArray());
+    QVERIFY(m_device.open(QIODevice::WriteOnly));
+}
+
+void DispatcherTest::cleanup()
+{
+    m_promises.clear();
+    m_device.close();
+}
+
+void DispatcherTest::single()
+{
+    m_dispatcher.dispatch(request("echo", 7), &m_device);
+
+    QJsonObject const response = QJsonDocument::fromJson(m_device.data()).object();
+    QCOMPARE(response.value(QStringLiteral("id")).toInt(), 7);
+    QCOMPARE(response.value(QStringLiteral("result")).toInt(), 7);
+}
+
+void DispatcherTest::singleNotification()
+{
+    m_dispatcher.dispatch(notification("echo"), &m_device);
+    QVERIFY(m_device.data().isEmpty());
+}
+
+void DispatcherTest::invalidMessage_data()
+{
+    QTest::addColumn<QByteArray>("message");
+    QTest::addColumn<int>("expected");
+
+    QTest::newRow("empty batch") << QByteArrayLiteral("[]") << errorCode(ServerError::RequestInvalid);
+    QTest::newRow("unknown method") << request("none", 1) << errorCode(ServerError::MethodNotFound);
+
+    QJsonParseError je;
+    QJsonDocument::fromJson(QByteArrayLiteral("{"), &je);
+    QTest::newRow("not json") << QByteArrayLiteral("{") << errorCode(je.error);
+}
+
+void DispatcherTest::invalidMessage()
+{
+    QFETCH(QByteArray, message);
+    QFETCH(int, expected);
+
+    m_dispatcher.dispatch(message, &m_device);
+    QJsonObject const response = QJsonDocument::fromJson(m_device.data()).object();
+    QCOMPARE(response.value(QStringLiteral("error")).toObject().value(QStringLiteral("code")).toInt(), expected);
+}
+
+void DispatcherTest::batch()
+{
+    // notifications are not answered, invalid elements are answered with null id
+    m_dispatcher.dispatch('[' + request("echo", 1) + ',' + notification("echo") + ",1," + request("none", 2) + ',' +
+                              request("echo", 3) + ']',
+                          &m_device);
+
+    QCOMPARE(ids(m_device.data()), (QList<int>{ 1, errorCode(ServerError::RequestInvalid), 2, 3 }));
+}
+
+void DispatcherTest::batchOfNotifications()
+{
+    m_dispatcher.dispatch('[' + notification("echo") + ',' + notification("none") + ']', &m_device);
+    QVERIFY(m_device.data().isEmpty());
+}
+
+void DispatcherTest::batchCollected()
+{
+    m_dispatcher.dispatch('[' + request("slow", 1) + ',' + request("echo", 2) + ']', &m_device);
+    QCOMPARE(m_promises.size(), 1);
+    QVERIFY(m_device.data().isEmpty());
+
+    m_promises.takeFirst().resolve(1);
+    QCOMPARE(ids(m_device.data()), (QList<int>{ 2, 1 }));
+}
+
+void DispatcherTest::batchStreaming()
+{
+    m_dispatcher.setBatchStreaming(true);
+    m_dispatcher.dispatch('[' + request("slow", 1) + ',' + request("echo", 2) + ',' + request("slow", 3) + ']',
+                          &m_device);
+
+    // completed element is already out, array is open
+    QByteArray const head = m_device.data();
+    QVERIFY(head.startsWith('['));
+    QVERIFY(!head.endsWith(']'));
+    QCOMPARE(QJsonDocument::fromJson(head.mid(1)).object().value(QStringLiteral("id")).toInt(), 2);
+
+    m_promises[ 1 ].resolve(3);
+    QCOMPARE(m_device.data().count('}'), 2);
+    m_promises[ 0 ].resolve(1);
+    QCOMPARE(ids(m_device.data()), (QList<int>{ 2, 3, 1 }));
+}
+
+void DispatcherTest::heldWhileStreaming()
+{
+    m_dispatcher.setBatchStreaming(true);
+    m_dispatcher.dispatch('[' + request("slow", 1) + ',' + request("echo", 2) + ']', &m_device);
+    QByteArray const head = m_device.data();
+
+    // single response to the same device waits for the open batch
+    m_dispatcher.dispatch(request("echo", 3), &m_device);
+    QCOMPARE(m_device.data(), head);
+
+    m_promises.takeFirst().resolve(1);
+    QByteArray const output = m_device.data();
+    int const end = output.indexOf(']') + 1;
+    QCOMPARE(ids(output.left(end)), (QList<int>{ 2, 1 }));
+    QCOMPARE(QJsonDocument::fromJson(output.mid(end)).object().value(QStringLiteral("id")).toInt(), 3);
+}
+
+QTEST_GUILESS_MAIN(DispatcherTest)
+
+#include "tst_dispatcher.moc"
@@ -0,0 +1,184 @@
+#include <qjsonrpc/qjson-rpc-frame.hpp>
+
+#include <QtTest>
+
+using namespace rpc::qjson;
+
+
+class FrameCodecTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void roundTrip();
+    void splitFrame();
+    void severalFrames();
+    void oversizedBuffered();
+    void oversizedPartial();
+    void unknownFlags();
+    void compressed();
+};
+
+
+void FrameCodecTest::roundTrip()
+{
+    FrameCodec codec;
+    QByteArray const message = QByteArrayLiteral(R"({"jsonrpc":"2.0","method":"ping"})");
+    QByteArray const frame = codec.encode(message);
+    QCOMPARE(frame.size(), frame_header_size + message.size());
+
+    codec.append(frame);
+    QByteArray decoded;
+    QCOMPARE(codec.decode(decoded), 0);
+    QCOMPARE(decoded, message);
+    QCOMPARE(codec.bufferedBytes(), 0);
+
+    // nothing left
+    QCOMPARE(codec.decode(decoded), 0);
+    QVERIFY(decoded.isNull());
+}
+
+void FrameCodecTest::splitFrame()
+{
+    FrameCodec codec;
+    QByteArray const message(100, 'x');
+    QByteArray const frame = codec.encode(message);
+
+    // header split too, message appears with the last byte only
+    QByteArray decoded;
+    for (int i = 0; i < frame.size() - 1; ++i) {
+        codec.append(frame.mid(i, 1));
+        QCOMPARE(codec.decode(decoded), 0);
+        QVERIFY(decoded.isNull());
+    }
+
+    codec.append(frame.right(1));
+    QCOMPARE(codec.decode(decoded), 0);
+    QCOMPARE(decoded, message);
+}
+
+void FrameCodecTest::severalFrames()
+{
+    FrameCodec codec;
+    QByteArray const first = QByteArrayLiteral("first");
+    QByteArray const second = QByteArrayLiteral("second");
+    QByteArray const third = QByteArrayLiteral("third");
+    QByteArray const stream = codec.encode(first) + codec.encode(second) + codec.encode(third);
+
+    // chunks cut across frame boundaries
+    QByteArray decoded;
+    codec.append(stream.left(7));
+    QCOMPARE(codec.decode(decoded), 0);
+    QVERIFY(decoded.isNull());
+
+    codec.append(stream.mid(7, 12));
+    QCOMPARE(codec.decode(decoded), 0);
+    QCOMPARE(decoded, first);
+    QCOMPARE(codec.decode(decoded), 0);
+    QVERIFY(decoded.isNull());
+
+    codec.append(stream.mid(19));
+    QCOMPARE(codec.decode(decoded), 0);
+    QCOMPARE(decoded, second);
+    QCOMPARE(codec.decode(decoded), 0);
+    QCOMPARE(decoded, third);
+    QCOMPARE(codec.bufferedBytes(), 0);
+}
+
+void FrameCodecTest::oversizedBuffered()
+{
+    FrameCodec codec;
+    codec.setMaxMessageSize(16);
+
+    QByteArray const fits(16, 'a');
+    QByteArray const next = QByteArrayLiteral("next");
+    codec.append(codec.encode(QByteArray(17, 'b')) + codec.encode(fits) + codec.encode(next));
+
+    QByteArray decoded;
+    QCOMPARE(codec.decode(decoded), errorCode(ParseError::DocumentTooLarge));
+    QVERIFY(decoded.isNull());
+
+    // exactly at the limit is fine
+    QCOMPARE(codec.decode(decoded), 0);
+    QCOMPARE(decoded, fits);
+    QCOMPARE(codec.decode(decoded), 0);
+    QCOMPARE(decoded, next);
+    QCOMPARE(codec.bufferedBytes(), 0);
+}
+
+void FrameCodecTest::oversizedPartial()
+{
+    FrameCodec sender;
+    QByteArray const oversized = sender.encode(QByteArray(1000, 'b'));
+    QByteArray const next = QByteArrayLiteral("next");
+
+    FrameCodec codec;
+    codec.setMaxMessageSize(64);
+
+    // rejected by length prefix before payload arrives
+    QByteArray decoded;
+    codec.append(oversized.left(frame_header_size + 10));
+    QCOMPARE(codec.decode(decoded), errorCode(ParseError::DocumentTooLarge));
+    QCOMPARE(codec.bufferedBytes(), 0);
+
+    // rest of the payload is discarded as it arrives, even split with the next frame
+    codec.append(oversized.mid(frame_header_size + 10, 500));
+    QCOMPARE(codec.bufferedBytes(), 0);
+    QCOMPARE(codec.decode(decoded), 0);
+    QVERIFY(decoded.isNull());
+
+    codec.append(oversized.mid(frame_header_size + 510) + sender.encode(next).left(3));
+    QCOMPARE(codec.bufferedBytes(), 3);
+    QCOMPARE(codec.decode(decoded), 0);
+    QVERIFY(decoded.isNull());
+
+    codec.append(sender.encode(next).mid(3));
+    QCOMPARE(codec.decode(decoded), 0);
+    QCOMPARE(decoded, next);
+}
+
+void FrameCodecTest::unknownFlags()
+{
+    FrameCodec codec;
+    QByteArray invalid = codec.encode(QByteArrayLiteral("invalid"));
+    invalid[ 4 ] = static_cast<char>(0x80);
+    QByteArray const next = QByteArrayLiteral("next");
+    codec.append(invalid + codec.encode(next));
+
+    QByteArray decoded;
+    QCOMPARE(codec.decode(decoded), errorCode(TransportError::FrameInvalid));
+    QCOMPARE(codec.decode(decoded), 0);
+    QCOMPARE(decoded, next);
+}
+
+void FrameCodecTest::compressed()
+{
+    FrameCodec client, server;
+    client.setCompressionEnabled(true);
+    server.setCompressionEnabled(true);
+    QByteArray const message(4 * compression_default_threshold, 'z');
+
+    // first frame goes uncompressed, it announces the acceptance
+    server.append(client.encode(QByteArrayLiteral("hello")));
+    QByteArray decoded;
+    QCOMPARE(server.decode(decoded), 0);
+    QVERIFY(server.isPeerAcceptingCompressed());
+
+    QByteArray const frame = server.encode(message);
+    QVERIFY(frame.size() < message.size());
+    QCOMPARE(server.stats().compressed, quint64(1));
+
+    client.append(frame);
+    QCOMPARE(client.decode(decoded), 0);
+    QCOMPARE(decoded, message);
+
+    // uncompressed size is checked before inflating
+    FrameCodec limited;
+    limited.setMaxMessageSize(1024);
+    limited.append(frame);
+    QCOMPARE(limited.decode(decoded), errorCode(ParseError::DocumentTooLarge));
+}
+
+QTEST_APPLESS_MAIN(FrameCodecTest)
+
+#include "tst_frame.moc"
@@ -0,0 +1,177 @@
+#include <qjsonrpc/qjson-rpc-dispatcher.hpp>
+#include <qjsonrpc/qjson-rpc-inflight.hpp>
+
+#include <QBuffer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QThreadPool>
+#include <QtTest>
+
+#include <algorithm>
+
+using namespace rpc::qjson;
+
+
+namespace {
+
+[[nodiscard]] RequestObject request(int id, int param = 0)
+{
+    return RequestObject(QStringLiteral("m"), id, QJsonArray{ param });
+}
+
+[[nodiscard]] QByteArray message(QByteArray const &method, int id)
+{
+    return "{\"jsonrpc\":\"2.0\",\"method\":\"" + method + "\",\"params\":[],\"id\":" + QByteArray::number(id) + '}';
+}
+
+[[nodiscard]] QJsonObject object(QByteArray const &json)
+{
+    return QJsonDocument::fromJson(json).object();
+}
+
+} // namespace
+
+
+class InflightTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void leaderAndFollowers();
+    void differentParams();
+    void errorForFollowers();
+    void dispatcherCoalescing();
+    void completionInDeviceThread();
+    void deviceDestroyed();
+};
+
+
+void InflightTest::leaderAndFollowers()
+{
+    InflightGroup group;
+    QList<QByteArray> responses;
+    auto const collect = [&responses](QByteArray const &response) { responses.append(response); };
+
+    QVERIFY(group.join(request(1), collect));
+    QVERIFY(!group.join(request(2), collect));
+    QVERIFY(!group.join(request(3), collect));
+    QCOMPARE(group.inflightCount(), 1);
+    QCOMPARE(group.coalescedCount(), quint64(2));
+
+    // leader answers itself, followers get its result under their own ids
+    group.finish(request(1), ResponseObject(QJsonValue(1), QStringLiteral("r")));
+    QCOMPARE(responses.size(), 2);
+    QCOMPARE(object(responses.at(0)).value(QStringLiteral("id")).toInt(), 2);
+    QCOMPARE(object(responses.at(1)).value(QStringLiteral("id")).toInt(), 3);
+    QCOMPARE(object(responses.at(1)).value(QStringLiteral("result")).toString(), QStringLiteral("r"));
+    QCOMPARE(group.inflightCount(), 0);
+
+    // finished call is executed again
+    QVERIFY(group.join(request(4), collect));
+    group.finish(request(4), ResponseObject(QJsonValue(4), 4));
+    QCOMPARE(responses.size(), 2);
+}
+
+void InflightTest::differentParams()
+{
+    InflightGroup group;
+    QVERIFY(group.join(request(1, 1), {}));
+    QVERIFY(group.join(request(2, 2), {}));
+    QCOMPARE(group.inflightCount(), 2);
+    QCOMPARE(group.coalescedCount(), quint64(0));
+}
+
+void InflightTest::errorForFollowers()
+{
+    InflightGroup group;
+    QByteArray response;
+    QVERIFY(group.join(request(1), {}));
+    QVERIFY(!group.join(request(2), [&response](QByteArray const &r) { response = r; }));
+
+    group.finish(request(1), ResponseObject(ErrorObject(errorCode(ServerError::Internal)), 1));
+    QJsonObject const error = object(response);
+    QCOMPARE(error.value(QStringLiteral("id")).toInt(), 2);
+    QCOMPARE(error.value(QStringLiteral("error")).toObject().value(QStringLiteral("code")).toInt(),
+             errorCode(ServerError::Internal));
+}
+
+void InflightTest::dispatcherCoalescing()
+{
+    Dispatcher dispatcher;
+    dispatcher.setCoalescing(true);
+    QList<ResponsePromise> promises;
+    dispatcher.addAsyncMethod(QStringLiteral("slow"),
+                              [&promises](RequestObject const &, ResponsePromise promise, CancellationToken const &) {
+                                  promises.append(promise);
+                              });
+
+    QList<QByteArray> responses;
+    auto const collect = [&responses](QByteArray const &response) { responses.append(response); };
+    dispatcher.invoke(object(message("slow", 1)), collect);
+    dispatcher.invoke(object(message("slow", 2)), collect);
+    QCOMPARE(promises.size(), 1);
+    QCOMPARE(dispatcher.inflight().coalescedCount(), quint64(1));
+
+    promises.first().resolve(42);
+    QCOMPARE(responses.size(), 2);
+    QList<int> ids;
+    for (QByteArray const &response : qAsConst(responses)) {
+        ids.append(object(response).value(QStringLiteral("id")).toInt());
+        QCOMPARE(object(response).value(QStringLiteral("result")).toInt(), 42);
+    }
+    std::sort(ids.begin(), ids.end());
+    QCOMPARE(ids, (QList<int>{ 1, 2 }));
+    QCOMPARE(dispatcher.inflight().inflightCount(), 0);
+}
+
+void InflightTest::completionInDeviceThread()
+{
+    Dispatcher dispatcher;
+    QThreadPool pool;
+    // one worker, so responses come in dispatch order
+    pool.setMaxThreadCount(1);
+    dispatcher.setThreadPool(&pool);
+
+    QThread *handler_thread = nullptr;
+    dispatcher.addMethod(QStringLiteral("where"), [&handler_thread](RequestObject const &request) {
+        handler_thread = QThread::currentThread();
+        return ResponseObject(request.id(), true);
+    });
+
+    QBuffer device;
+    QVERIFY(device.open(QIODevice::WriteOnly));
+    dispatcher.dispatch(message("where", 1), &device);
+    dispatcher.dispatch('[' + message("where", 2) + ',' + message("where", 3) + ']', &device);
+
+    // handlers run on the pool, responses are written by device's thread
+    QTRY_VERIFY(device.data().endsWith(']'));
+    QVERIFY(pool.waitForDone());
+    QVERIFY(handler_thread != QThread::currentThread());
+    QCOMPARE(object(device.data().left(device.data().indexOf('['))).value(QStringLiteral("id")).toInt(), 1);
+}
+
+void InflightTest::deviceDestroyed()
+{
+    Dispatcher dispatcher;
+    QList<ResponsePromise> promises;
+    dispatcher.addAsyncMethod(QStringLiteral("slow"),
+                              [&promises](RequestObject const &, ResponsePromise promise, CancellationToken const &) {
+                                  promises.append(promise);
+                              });
+
+    auto *const device = new QBuffer;
+    QVERIFY(device->open(QIODevice::WriteOnly));
+    dispatcher.dispatch(message("slow", 1), device);
+    dispatcher.dispatch('[' + message("slow", 2) + ',' + message("slow", 3) + ']', device);
+    QCOMPARE(promises.size(), 3);
+    delete device;
+
+    // completions of the gone device are dropped
+    for (ResponsePromise &promise : promises)
+        promise.resolve(true);
+    QCoreApplication::processEvents();
+}
+
+QTEST_GUILESS_MAIN(InflightTest)
+
+#include "tst_inflight.moc"
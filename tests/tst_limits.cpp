@@ -0,0 +1,157 @@
+#include <qjsonrpc/qjson-rpc-scanner.hpp>
+
+#include <QtTest>
+
+using namespace rpc::qjson;
+
+
+namespace {
+
+[[nodiscard]] QByteArray array(int count, QByteArray const &element = QByteArrayLiteral("1"))
+{
+    QByteArrayList elements;
+    for (int i = 0; i < count; ++i)
+        elements.append(element);
+    return '[' + elements.join(',') + ']';
+}
+
+[[nodiscard]] QByteArray nested(int depth)
+{
+    return QByteArray(depth, '[') + QByteArray(depth, ']');
+}
+
+[[nodiscard]] QByteArray batch(int count)
+{
+    return array(count, QByteArrayLiteral(R"({"jsonrpc":"2.0","method":"m","params":[1,2,3],"id":1})"));
+}
+
+} // namespace
+
+
+class LimitsTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void maxElements_data();
+    void maxElements();
+    void maxBatchSize_data();
+    void maxBatchSize();
+    void maxDepth_data();
+    void maxDepth();
+    void maxBytes();
+    void maxStringLength();
+};
+
+
+void LimitsTest::maxElements_data()
+{
+    QTest::addColumn<QByteArray>("message");
+    QTest::addColumn<int>("expected");
+
+    int const too_large = errorCode(ParseError::DocumentTooLarge);
+
+    QTest::newRow("empty") << QByteArrayLiteral("[]") << 0;
+    QTest::newRow("below") << array(3) << 0;
+    QTest::newRow("at") << array(4) << 0;
+    QTest::newRow("above") << array(5) << too_large;
+    QTest::newRow("object at") << QByteArrayLiteral(R"({"a":1,"b":2,"c":3,"d":4})") << 0;
+    QTest::newRow("object above") << QByteArrayLiteral(R"({"a":1,"b":2,"c":3,"d":4,"e":5})") << too_large;
+    // per container, not in total
+    QTest::newRow("nested at") << array(4, array(4)) << 0;
+    QTest::newRow("nested above") << array(4, array(5)) << too_large;
+}
+
+void LimitsTest::maxElements()
+{
+    QFETCH(QByteArray, message);
+    QFETCH(int, expected);
+
+    JsonLimits limits;
+    limits.max_elements = 4;
+    QCOMPARE(checkLimits(message, limits), expected);
+}
+
+void LimitsTest::maxBatchSize_data()
+{
+    QTest::addColumn<QByteArray>("message");
+    QTest::addColumn<int>("max_elements");
+    QTest::addColumn<int>("expected");
+
+    int const too_large = errorCode(ParseError::DocumentTooLarge);
+
+    QTest::newRow("empty") << QByteArrayLiteral("[]") << 0 << 0;
+    QTest::newRow("at") << batch(3) << 0 << 0;
+    QTest::newRow("above") << batch(4) << 0 << too_large;
+    // batch size limit replaces element limit of the batch array itself, but not of its elements
+    QTest::newRow("at, elements below") << batch(3) << 2 << errorCode(ParseError::DocumentTooLarge);
+    QTest::newRow("at, elements at") << batch(3) << 4 << 0;
+    QTest::newRow("single request") << QByteArrayLiteral(R"({"jsonrpc":"2.0","method":"m","id":1})") << 0 << 0;
+    QTest::newRow("unterminated") << batch(3).chopped(1) << 0 << errorCode(ParseError::UnterminatedArray);
+}
+
+void LimitsTest::maxBatchSize()
+{
+    QFETCH(QByteArray, message);
+    QFETCH(int, max_elements);
+    QFETCH(int, expected);
+
+    JsonLimits limits;
+    limits.max_batch_size = 3;
+    limits.max_elements = max_elements;
+    QCOMPARE(checkLimits(message, limits), expected);
+}
+
+void LimitsTest::maxDepth_data()
+{
+    QTest::addColumn<QByteArray>("message");
+    QTest::addColumn<int>("max_batch_size");
+    QTest::addColumn<int>("expected");
+
+    int const deep = errorCode(ParseError::DeepNesting);
+
+    QTest::newRow("below") << nested(7) << 0 << 0;
+    QTest::newRow("at") << nested(8) << 0 << 0;
+    QTest::newRow("above") << nested(9) << 0 << deep;
+    QTest::newRow("object at") << QByteArrayLiteral(R"({"a":{"b":{"c":{"d":{"e":{"f":{"g":{}}}}}}}})") << 0 << 0;
+    QTest::newRow("object above") << QByteArrayLiteral(R"({"a":{"b":{"c":{"d":{"e":{"f":{"g":{"h":{}}}}}}}}})") << 0
+                                  << deep;
+    // batch array takes one level when elements are counted separately
+    QTest::newRow("batch at") << QByteArray('[' + nested(7) + ']') << 4 << 0;
+    QTest::newRow("batch above") << QByteArray('[' + nested(8) + ']') << 4 << deep;
+}
+
+void LimitsTest::maxDepth()
+{
+    QFETCH(QByteArray, message);
+    QFETCH(int, max_batch_size);
+    QFETCH(int, expected);
+
+    JsonLimits limits;
+    limits.max_depth = 8;
+    limits.max_batch_size = max_batch_size;
+    QCOMPARE(checkLimits(message, limits), expected);
+}
+
+void LimitsTest::maxBytes()
+{
+    JsonLimits limits;
+    limits.max_bytes = 7;
+    QCOMPARE(checkLimits(array(3), limits), 0);
+    QCOMPARE(checkLimits(array(4), limits), errorCode(ParseError::DocumentTooLarge));
+}
+
+void LimitsTest::maxStringLength()
+{
+    JsonLimits limits;
+    limits.max_string_length = 4;
+    QCOMPARE(checkLimits(QByteArrayLiteral(R"(["abcd"])"), limits), 0);
+    QCOMPARE(checkLimits(QByteArrayLiteral(R"(["abcde"])"), limits), errorCode(ParseError::DocumentTooLarge));
+    // raw bytes, escape sequence is not decoded
+    QCOMPARE(checkLimits(QByteArrayLiteral(R"(["ab\n"])"), limits), 0);
+    QCOMPARE(checkLimits(QByteArrayLiteral(R"(["abc\n"])"), limits), errorCode(ParseError::DocumentTooLarge));
+}
+
+QTEST_APPLESS_MAIN(LimitsTest)
+
+#include "tst_limits.moc"
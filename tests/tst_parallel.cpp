@@ -0,0 +1,183 @@
+#include <qjsonrpc/qjson-rpc-parallel.hpp>
+#include <qjsonrpc/qjson-rpc-peek.hpp>
+
+#include <QJsonDocument>
+#include <QThread>
+#include <QThreadPool>
+#include <QtTest>
+
+using namespace rpc::qjson;
+
+
+namespace {
+
+// big enough for the parallel path, about 50 bytes per element
+[[nodiscard]] QByteArray bigArray(int count, QByteArray const &last = QByteArray())
+{
+    QByteArray raw = "[";
+    for (int i = 0; i < count; ++i)
+        raw += "{\"i\":" + QByteArray::number(i) + ",\"s\":\"" + QByteArray(32, 'x') + "\"},";
+    if (last.isEmpty())
+        raw.chop(1);
+    else
+        raw += last;
+    return raw + ']';
+}
+
+int const big_count = 30'000;
+
+} // namespace
+
+
+class ParallelTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void chunkOrder();
+    void empty();
+    void errors_data();
+    void errors();
+    void chunkError();
+    void wholeArray();
+    void params();
+
+private:
+    QThreadPool *m_pool = nullptr;
+};
+
+
+void ParallelTest::init()
+{
+    m_pool = new QThreadPool;
+    m_pool->setMaxThreadCount(4);
+}
+
+void ParallelTest::cleanup()
+{
+    delete m_pool;
+    m_pool = nullptr;
+}
+
+void ParallelTest::chunkOrder()
+{
+    QByteArray const raw = bigArray(big_count);
+    int chunks = 0;
+    int next = 0;
+    bool calling_thread = true;
+    auto const sink = [&](QJsonArray const &chunk) {
+        chunks++;
+        calling_thread = calling_thread && QThread::currentThread() == thread();
+        for (QJsonValue const &element : chunk) {
+            if (element.toObject().value(QStringLiteral("i")).toInt() != next)
+                return;
+            next++;
+        }
+    };
+
+    QCOMPARE(parseArray(raw, 0, raw.size(), sink, m_pool), 0);
+    QVERIFY(chunks > 1);
+    QVERIFY(calling_thread);
+    QCOMPARE(next, big_count);
+}
+
+void ParallelTest::empty()
+{
+    int chunks = 0;
+    auto const sink = [&chunks](QJsonArray const &) { chunks++; };
+
+    QByteArray const raw = QByteArrayLiteral(" [ ] ");
+    QCOMPARE(parseArray(raw, 0, raw.size(), sink, m_pool), 0);
+    QCOMPARE(chunks, 0);
+}
+
+void ParallelTest::errors_data()
+{
+    QTest::addColumn<QByteArray>("raw");
+    QTest::addColumn<int>("expected");
+
+    QTest::newRow("not array") << QByteArrayLiteral(R"({"a":1})") << errorCode(ParseError::IllegalValue);
+    QTest::newRow("unterminated") << QByteArrayLiteral("[1,2") << errorCode(ParseError::UnterminatedArray);
+    QTest::newRow("missing value separator")
+        << QByteArrayLiteral("[1 2]") << errorCode(ParseError::MissingValueSeparator);
+    QTest::newRow("garbage at end") << QByteArrayLiteral("[1,2] x") << errorCode(ParseError::GarbageAtEnd);
+    QTest::newRow("illegal value") << QByteArrayLiteral("[1,x]") << errorCode(ParseError::IllegalValue);
+    QTest::newRow("unterminated string")
+        << QByteArrayLiteral(R"([1,"abc])") << errorCode(ParseError::UnterminatedString);
+}
+
+void ParallelTest::errors()
+{
+    QFETCH(QByteArray, raw);
+    QFETCH(int, expected);
+
+    // structural errors are found before any chunk is parsed
+    int chunks = 0;
+    auto const sink = [&chunks](QJsonArray const &) { chunks++; };
+    QCOMPARE(parseArray(raw, 0, raw.size(), sink, m_pool), expected);
+    QCOMPARE(chunks, 0);
+}
+
+void ParallelTest::chunkError()
+{
+    // NOTE: scanner skips numbers loosely, the one the parser rejects fails its chunk
+    QJsonParseError je;
+    QJsonDocument::fromJson(QByteArrayLiteral("[1e]"), &je);
+    QVERIFY(je.error != QJsonParseError::NoError);
+
+    QByteArray const raw = bigArray(big_count, QByteArrayLiteral("1e"));
+    int chunks = 0;
+    int next = 0;
+    bool ordered = true;
+    auto const sink = [&](QJsonArray const &chunk) {
+        chunks++;
+        for (QJsonValue const &element : chunk)
+            ordered = ordered && element.toObject().value(QStringLiteral("i")).toInt() == next++;
+    };
+
+    // chunks before the failed one are delivered in order, the failed one and later ones are not
+    QCOMPARE(parseArray(raw, 0, raw.size(), sink, m_pool), errorCode(je.error));
+    QVERIFY(chunks > 0);
+    QVERIFY(ordered);
+    QVERIFY(next < big_count);
+}
+
+void ParallelTest::wholeArray()
+{
+    QByteArray const raw = bigArray(big_count);
+    QVERIFY(raw.size() >= parallel_parse_min_bytes);
+
+    QJsonArray array;
+    QCOMPARE(parseArray(raw, 0, raw.size(), array, m_pool), 0);
+    QCOMPARE(array, QJsonDocument::fromJson(raw).array());
+
+    // small one is parsed in place, errors are the parser's
+    QByteArray const small = QByteArrayLiteral("[1,2,3]");
+    QCOMPARE(parseArray(small, 0, small.size(), array, m_pool), 0);
+    QCOMPARE(array, (QJsonArray{ 1, 2, 3 }));
+
+    QByteArray const object = QByteArrayLiteral(R"({"a":1})");
+    QCOMPARE(parseArray(object, 0, object.size(), array, m_pool), errorCode(ParseError::IllegalValue));
+    QVERIFY(array.isEmpty());
+}
+
+void ParallelTest::params()
+{
+    QByteArray const params = bigArray(big_count);
+    QByteArray const raw = R"({"jsonrpc":"2.0","method":"m","params":)" + params + R"(,"id":1})";
+
+    EnvelopePeek peek;
+    QCOMPARE(peekEnvelope(raw, peek), 0);
+
+    QJsonArray array;
+    QCOMPARE(parseArray(raw, peek.params_begin, peek.params_end, array, m_pool), 0);
+    QCOMPARE(array.size(), big_count);
+    QCOMPARE(array.last().toObject().value(QStringLiteral("i")).toInt(), big_count - 1);
+}
+
+QTEST_APPLESS_MAIN(ParallelTest)
+
+#include "tst_parallel.moc"
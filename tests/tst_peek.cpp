@@ -0,0 +1,131 @@
+#include <qjsonrpc/qjson-rpc-peek.hpp>
+
+#include <QtTest>
+
+using namespace rpc::qjson;
+
+
+class PeekTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void errors_data();
+    void errors();
+    void fields();
+    void notification();
+    void batch();
+    void maxBytes();
+};
+
+
+void PeekTest::errors_data()
+{
+    QTest::addColumn<QByteArray>("message");
+    QTest::addColumn<int>("expected");
+
+    QTest::newRow("empty") << QByteArray() << errorCode(ParseError::MissingObject);
+    QTest::newRow("not object") << QByteArrayLiteral(R"("x")") << errorCode(ParseError::MissingObject);
+    QTest::newRow("unterminated object")
+        << QByteArrayLiteral(R"({"jsonrpc":"2.0","method":"m")") << errorCode(ParseError::UnterminatedObject);
+    QTest::newRow("missing value separator")
+        << QByteArrayLiteral(R"({"jsonrpc":"2.0" "method":"m"})") << errorCode(ParseError::MissingValueSeparator);
+    QTest::newRow("missing name separator")
+        << QByteArrayLiteral(R"({"jsonrpc":"2.0","method" "m"})") << errorCode(ParseError::MissingNameSeparator);
+    QTest::newRow("key not string") << QByteArrayLiteral(R"({1:"2.0"})") << errorCode(ParseError::IllegalValue);
+    QTest::newRow("unterminated string")
+        << QByteArrayLiteral(R"({"jsonrpc":"2.0","method":"m","params":"[1,2)")
+        << errorCode(ParseError::UnterminatedString);
+    QTest::newRow("garbage at end")
+        << QByteArrayLiteral(R"({"jsonrpc":"2.0","method":"m"} x)") << errorCode(ParseError::GarbageAtEnd);
+
+    QTest::newRow("no version") << QByteArrayLiteral(R"({"method":"m","id":1})")
+                                << errorCode(ServerError::RequestInvalid);
+    QTest::newRow("no version notification")
+        << QByteArrayLiteral(R"({"method":"m"})") << errorCode(ServerError::NotificationInvalid);
+    QTest::newRow("method not string")
+        << QByteArrayLiteral(R"({"jsonrpc":"2.0","method":1,"id":1})") << errorCode(ServerError::RequestInvalid);
+    QTest::newRow("version") << QByteArrayLiteral(R"({"jsonrpc":"1.0","method":"m","id":1})")
+                             << errorCode(ServerError::RpcVersionUnsupported);
+    QTest::newRow("reserved")
+        << QByteArrayLiteral(R"({"jsonrpc":"2.0","method":"rpc.m","id":1})") << errorCode(ServerError::MethodReserved);
+    QTest::newRow("id bool")
+        << QByteArrayLiteral(R"({"jsonrpc":"2.0","method":"m","id":true})") << errorCode(ServerError::RequestInvalid);
+    QTest::newRow("id object")
+        << QByteArrayLiteral(R"({"jsonrpc":"2.0","method":"m","id":{}})") << errorCode(ServerError::RequestInvalid);
+    QTest::newRow("id fraction")
+        << QByteArrayLiteral(R"({"jsonrpc":"2.0","method":"m","id":1.5})") << errorCode(ServerError::RequestInvalid);
+    QTest::newRow("params scalar") << QByteArrayLiteral(R"({"jsonrpc":"2.0","method":"m","params":1,"id":1})")
+                                   << errorCode(ServerError::ParametersInvalid);
+
+    QTest::newRow("id negative") << QByteArrayLiteral(R"({"jsonrpc":"2.0","method":"m","id":-1})") << 0;
+    QTest::newRow("id integral exponent") << QByteArrayLiteral(R"({"jsonrpc":"2.0","method":"m","id":1e2})") << 0;
+}
+
+void PeekTest::errors()
+{
+    QFETCH(QByteArray, message);
+    QFETCH(int, expected);
+
+    EnvelopePeek peek;
+    QCOMPARE(peekEnvelope(message, peek), expected);
+}
+
+void PeekTest::fields()
+{
+    QByteArray const message = QByteArrayLiteral(
+        R"( { "id" : "a", "jsonrpc":"2.0", "method":"s\u0075m", "params":[1, {"x":2}], "x":0, "id":2 } )");
+
+    EnvelopePeek peek;
+    QCOMPARE(peekEnvelope(message, peek), 0);
+    QVERIFY(!peek.batch);
+    QCOMPARE(peek.jsonrpc, QByteArrayLiteral("2.0"));
+    // escape sequences are kept as is
+    QCOMPARE(peek.method, QByteArrayLiteral(R"(s\u0075m)"));
+    QCOMPARE(peek.id, QByteArrayLiteral(R"("a")"));
+    QVERIFY(!peek.isNotification());
+
+    QVERIFY(peek.hasParams());
+    QCOMPARE(message.mid(peek.params_begin, peek.params_end - peek.params_begin), QByteArrayLiteral(R"([1, {"x":2}])"));
+
+    // unknown and repeated members
+    QCOMPARE(peek.extra_members, 2);
+}
+
+void PeekTest::notification()
+{
+    EnvelopePeek peek;
+    QCOMPARE(peekEnvelope(QByteArrayLiteral(R"({"jsonrpc":"2.0","method":"m"})"), peek), 0);
+    QVERIFY(peek.isNotification());
+    QVERIFY(!peek.hasParams());
+    QCOMPARE(peek.params_begin, -1);
+    QCOMPARE(peek.extra_members, 0);
+}
+
+void PeekTest::batch()
+{
+    EnvelopePeek peek;
+    peek.extra_members = 5;
+    QCOMPARE(peekEnvelope(QByteArrayLiteral(R"( [{"jsonrpc":"2.0","method":"m"}])"), peek), 0);
+    QVERIFY(peek.batch);
+    QVERIFY(peek.method.isNull());
+    QCOMPARE(peek.extra_members, 0);
+}
+
+void PeekTest::maxBytes()
+{
+    QByteArray const message = QByteArrayLiteral(R"({"jsonrpc":"2.0","method":"m"})");
+
+    JsonLimits limits;
+    limits.max_bytes = message.size();
+    EnvelopePeek peek;
+    QCOMPARE(peekEnvelope(message, peek, limits), 0);
+
+    limits.max_bytes = message.size() - 1;
+    QCOMPARE(peekEnvelope(message, peek, limits), errorCode(ParseError::DocumentTooLarge));
+    QCOMPARE(peek.method, QByteArray());
+}
+
+QTEST_APPLESS_MAIN(PeekTest)
+
+#include "tst_peek.moc"
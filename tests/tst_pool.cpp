@@ -0,0 +1,273 @@
+#include <qjsonrpc/qjson-rpc-frame.hpp>
+#include <qjsonrpc/qjson-rpc-pool.hpp>
+#include <qjsonrpc/qjson-rpc-writer.hpp>
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QtTest>
+
+#include <cstring>
+
+using namespace rpc::qjson;
+
+
+namespace {
+
+QString const probe_method = QStringLiteral("ping");
+
+// server side of one pooled connection, messages are exchanged in frames
+class Peer : public QIODevice
+{
+public:
+    enum class Probes
+    {
+        Answer,
+        AnswerWithNullIdError,
+    };
+
+    Peer() { open(QIODevice::ReadWrite); }
+
+    bool isSequential() const override { return true; }
+    qint64 bytesAvailable() const override { return m_incoming.size() + QIODevice::bytesAvailable(); }
+
+    void reply(QJsonObject const &response)
+    {
+        m_incoming += FrameCodec().encode(toJson(response));
+        emit readyRead();
+    }
+
+    // requests but probes
+    QList<QJsonObject> received;
+    Probes probes = Probes::Answer;
+    int probe_count = 0;
+
+protected:
+    qint64 readData(char *data, qint64 size) override
+    {
+        int const count = static_cast<int>(qMin<qint64>(size, m_incoming.size()));
+        std::memcpy(data, m_incoming.constData(), static_cast<size_t>(count));
+        m_incoming.remove(0, count);
+        return count;
+    }
+
+    qint64 writeData(char const *data, qint64 size) override
+    {
+        m_codec.append(QByteArray(data, static_cast<int>(size)));
+        QByteArray message;
+        while (m_codec.decode(message) == 0 && !message.isNull()) {
+            QJsonObject const request = QJsonDocument::fromJson(message).object();
+            if (request.value(QStringLiteral("method")).toString() != probe_method) {
+                received.append(request);
+                continue;
+            }
+
+            // NOTE: answered later, like a remote peer would
+            probe_count++;
+            QJsonObject const answer = probes == Probes::Answer
+                                           ? ResponseObject(request.value(QStringLiteral("id")), true)
+                                           : ResponseObject(ErrorObject(errorCode(ServerError::RequestInvalid)));
+            QMetaObject::invokeMethod(this, [this, answer] { reply(answer); }, Qt::QueuedConnection);
+        }
+        return size;
+    }
+
+private:
+    FrameCodec m_codec;
+    QByteArray m_incoming;
+};
+
+[[nodiscard]] RequestObject request(int id)
+{
+    return RequestObject(QStringLiteral("m"), id, QJsonArray());
+}
+
+// answers index-th request the peer got, with the id pool put on the wire
+void answer(Peer &peer, int index, QJsonValue const &result)
+{
+    QJsonValue const id = peer.received.at(index).value(QStringLiteral("id"));
+    peer.reply(ResponseObject(id, result));
+}
+
+} // namespace
+
+
+class PoolTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void leastOutstanding();
+    void routeBack();
+    void notConnected();
+    void failover();
+    void callTimeout();
+    void healthCheck();
+
+private:
+    // connector of an endpoint, every device it opens is kept
+    [[nodiscard]] ConnectionPool::Connector connector();
+    // callback keeping the response under id
+    [[nodiscard]] ConnectionPool::Callback collect(int id);
+    [[nodiscard]] ResponseObject response(int id) const;
+
+    ConnectionPool *m_pool = nullptr;
+    QList<QPointer<Peer>> m_peers;
+    QHash<int, QJsonObject> m_responses;
+};
+
+
+void PoolTest::init()
+{
+    m_pool = new ConnectionPool;
+    m_pool->setReconnectBackoff(std::chrono::milliseconds(10), std::chrono::milliseconds(100));
+}
+
+void PoolTest::cleanup()
+{
+    delete m_pool;
+    m_pool = nullptr;
+    m_peers.clear();
+    m_responses.clear();
+}
+
+ConnectionPool::Connector PoolTest::connector()
+{
+    return [this]() -> QIODevice * {
+        auto *const peer = new Peer;
+        m_peers.append(peer);
+        return peer;
+    };
+}
+
+ConnectionPool::Callback PoolTest::collect(int id)
+{
+    return [this, id](ResponseObject const &response) { m_responses.insert(id, response); };
+}
+
+ResponseObject PoolTest::response(int id) const
+{
+    return ResponseObject(JsonRpcObject(m_responses.value(id)));
+}
+
+void PoolTest::leastOutstanding()
+{
+    m_pool->addEndpoint(connector(), 2);
+    QCOMPARE(m_pool->connectionCount(), 2);
+    QCOMPARE(m_pool->availableCount(), 2);
+
+    m_pool->call(request(1), collect(1));
+    m_pool->call(request(2), collect(2));
+    m_pool->call(request(3), collect(3));
+    QCOMPARE(m_peers.at(0)->received.size(), 2);
+    QCOMPARE(m_peers.at(1)->received.size(), 1);
+    QCOMPARE(m_pool->outstandingCount(), 3);
+
+    // answered connection is the less loaded one now
+    answer(*m_peers.at(0), 0, 1);
+    answer(*m_peers.at(0), 1, 3);
+    m_pool->call(request(4), collect(4));
+    QCOMPARE(m_peers.at(0)->received.size(), 3);
+
+    answer(*m_peers.at(1), 0, 2);
+    QCOMPARE(m_pool->notify(NotificationObject(QStringLiteral("n"))), 0);
+    QCOMPARE(m_peers.at(1)->received.size(), 2);
+    QCOMPARE(m_pool->outstandingCount(), 1);
+}
+
+void PoolTest::routeBack()
+{
+    m_pool->addEndpoint(connector());
+    m_pool->call(RequestObject(QStringLiteral("m"), QStringLiteral("mine")), collect(1));
+
+    // pool puts its own id on the wire
+    QJsonValue const wire_id = m_peers.first()->received.first().value(QStringLiteral("id"));
+    QVERIFY(wire_id != QJsonValue(QStringLiteral("mine")));
+
+    answer(*m_peers.first(), 0, 42);
+    QCOMPARE(m_responses.size(), 1);
+    QCOMPARE(response(1).id(), QJsonValue(QStringLiteral("mine")));
+    QCOMPARE(response(1).result().toInt(), 42);
+    QCOMPARE(m_pool->outstandingCount(), 0);
+
+    // unknown and repeated responses are dropped
+    m_peers.first()->reply(ResponseObject(wire_id, 42));
+    QCOMPARE(m_responses.size(), 1);
+}
+
+void PoolTest::notConnected()
+{
+    m_pool->addEndpoint([]() -> QIODevice * { return nullptr; });
+    QCOMPARE(m_pool->availableCount(), 0);
+
+    m_pool->call(request(1), collect(1));
+    QCOMPARE(response(1).error().code(), errorCode(TransportError::NotConnected));
+    QCOMPARE(m_pool->notify(NotificationObject(QStringLiteral("n"))), errorCode(TransportError::NotConnected));
+}
+
+void PoolTest::failover()
+{
+    QSignalSpy opened(m_pool, &ConnectionPool::connectionOpened);
+    QSignalSpy lost(m_pool, &ConnectionPool::connectionLost);
+    m_pool->addEndpoint(connector(), 2);
+    QCOMPARE(opened.count(), 2);
+
+    m_pool->call(request(1), collect(1));
+    m_pool->call(request(2), collect(2));
+    m_peers.at(0)->close();
+    QCOMPARE(m_pool->availableCount(), 1);
+
+    // calls on the lost connection fail, the other one is not touched
+    QTRY_COMPARE(lost.count(), 1);
+    QCOMPARE(lost.first().first().toInt(), 0);
+    QCOMPARE(response(1).error().code(), errorCode(TransportError::ConnectionLost));
+    QVERIFY(!m_responses.contains(2));
+
+    // reconnected after backoff
+    QTRY_COMPARE(opened.count(), 3);
+    QCOMPARE(m_pool->availableCount(), 2);
+    QCOMPARE(m_peers.size(), 3);
+
+    // fresh connection has nothing outstanding, so it takes the next call
+    m_pool->call(request(3), collect(3));
+    QCOMPARE(m_peers.at(2)->received.size(), 1);
+}
+
+void PoolTest::callTimeout()
+{
+    m_pool->setCallTimeout(std::chrono::milliseconds(50));
+    m_pool->addEndpoint(connector());
+    m_pool->call(request(1), collect(1));
+
+    QTRY_VERIFY(m_responses.contains(1));
+    QCOMPARE(response(1).error().code(), errorCode(TransportError::ResponseTimeout));
+    QCOMPARE(response(1).id().toInt(), 1);
+    QCOMPARE(m_pool->outstandingCount(), 0);
+
+    // late response is dropped
+    m_responses.clear();
+    answer(*m_peers.first(), 0, 1);
+    QVERIFY(m_responses.isEmpty());
+}
+
+void PoolTest::healthCheck()
+{
+    QSignalSpy lost(m_pool, &ConnectionPool::connectionLost);
+    m_pool->addEndpoint(connector());
+    m_pool->setHealthCheck(probe_method, std::chrono::milliseconds(20));
+
+    // answered probes keep the connection
+    QTRY_VERIFY(m_peers.first()->probe_count >= 3);
+    QCOMPARE(lost.count(), 0);
+    QVERIFY(m_peers.first()->received.isEmpty());
+
+    // error without id is not an answer to the probe
+    m_peers.first()->probes = Peer::Probes::AnswerWithNullIdError;
+    QTRY_COMPARE(lost.count(), 1);
+}
+
+QTEST_GUILESS_MAIN(PoolTest)
+
+#include "tst_pool.moc"
@@ -0,0 +1,218 @@
+#include <qjsonrpc/qjson-rpc-dispatcher.hpp>
+#include <qjsonrpc/qjson-rpc-promise.hpp>
+
+#include <QException>
+#include <QFutureInterface>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QMutex>
+#include <QtTest>
+
+#include <thread>
+#include <vector>
+
+using namespace rpc::qjson;
+
+
+namespace {
+
+int const internal = errorCode(ServerError::Internal);
+int const cancelled = errorCode(ServerExtendedError::Cancelled);
+
+[[nodiscard]] QJsonObject call(QString const &method, int id)
+{
+    return RequestObject(method, id, QJsonArray());
+}
+
+[[nodiscard]] int errorOf(QJsonObject const &response)
+{
+    return response.value(QStringLiteral("error")).toObject().value(QStringLiteral("code")).toInt();
+}
+
+} // namespace
+
+
+class PromiseTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void firstSettleWins();
+    void reject();
+    void copiesShareState();
+    void droppedUnsettled();
+    void settledFromThreads();
+    void futureResolved();
+    void futureFinishedLater();
+    void futureCanceled();
+    void futureException();
+
+private:
+    // completion keeping every response it gets
+    [[nodiscard]] ResponsePromise::Completion collect();
+    [[nodiscard]] Dispatcher::Completion collectMessage();
+
+    Dispatcher *m_dispatcher = nullptr;
+    QFutureInterface<QJsonValue> m_future;
+    QList<QJsonObject> m_responses;
+};
+
+
+void PromiseTest::init()
+{
+    // future handler hands out whatever future the test prepared
+    m_future = QFutureInterface<QJsonValue>();
+    m_future.reportStarted();
+    m_dispatcher = new Dispatcher;
+    m_dispatcher->addAsyncMethod(QStringLiteral("future"), [this](RequestObject const &) { return m_future.future(); });
+}
+
+void PromiseTest::cleanup()
+{
+    delete m_dispatcher;
+    m_dispatcher = nullptr;
+    m_responses.clear();
+}
+
+ResponsePromise::Completion PromiseTest::collect()
+{
+    return [this](ResponseObject const &response) { m_responses.append(response); };
+}
+
+Dispatcher::Completion PromiseTest::collectMessage()
+{
+    return [this](QByteArray const &response) { m_responses.append(QJsonDocument::fromJson(response).object()); };
+}
+
+void PromiseTest::firstSettleWins()
+{
+    ResponsePromise promise(1, collect());
+    QVERIFY(!promise.isSettled());
+    QCOMPARE(promise.id(), QJsonValue(1));
+
+    promise.resolve(QStringLiteral("r"));
+    promise.reject(ErrorObject(internal));
+    promise.respond(ResponseObject(QJsonValue(1), 2));
+    QVERIFY(promise.isSettled());
+    QCOMPARE(m_responses.size(), 1);
+    QCOMPARE(m_responses.first().value(QStringLiteral("id")).toInt(), 1);
+    QCOMPARE(m_responses.first().value(QStringLiteral("result")).toString(), QStringLiteral("r"));
+}
+
+void PromiseTest::reject()
+{
+    ResponsePromise promise(QStringLiteral("a"), collect());
+    promise.reject(ErrorObject(cancelled));
+    promise.resolve(1);
+
+    QCOMPARE(m_responses.size(), 1);
+    QCOMPARE(m_responses.first().value(QStringLiteral("id")).toString(), QStringLiteral("a"));
+    QCOMPARE(errorOf(m_responses.first()), cancelled);
+}
+
+void PromiseTest::copiesShareState()
+{
+    ResponsePromise const promise(1, collect());
+    ResponsePromise copy = promise;
+    copy.resolve(true);
+
+    QVERIFY(promise.isSettled());
+    QCOMPARE(m_responses.size(), 1);
+}
+
+void PromiseTest::droppedUnsettled()
+{
+    {
+        ResponsePromise promise(7, collect());
+        ResponsePromise const copy = promise;
+        promise = ResponsePromise(8, collect());
+        QVERIFY(m_responses.isEmpty());
+    }
+
+    // last copy of each answers with Internal error, as it goes away
+    QCOMPARE(m_responses.size(), 2);
+    QCOMPARE(m_responses.at(0).value(QStringLiteral("id")).toInt(), 7);
+    QCOMPARE(m_responses.at(1).value(QStringLiteral("id")).toInt(), 8);
+    QCOMPARE(errorOf(m_responses.at(0)), internal);
+    QCOMPARE(errorOf(m_responses.at(1)), internal);
+
+    // settled one is not answered again
+    m_responses.clear();
+    {
+        ResponsePromise promise(9, collect());
+        promise.resolve(true);
+    }
+    QCOMPARE(m_responses.size(), 1);
+}
+
+void PromiseTest::settledFromThreads()
+{
+    QMutex mutex;
+    QList<int> results;
+    ResponsePromise promise(1, [&mutex, &results](ResponseObject const &response) {
+        QMutexLocker locker(&mutex);
+        results.append(response.result().toInt());
+    });
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 8; ++i)
+        threads.emplace_back([promise, i]() mutable { promise.resolve(i); });
+    for (std::thread &thread : threads)
+        thread.join();
+
+    QCOMPARE(results.size(), 1);
+}
+
+void PromiseTest::futureResolved()
+{
+    m_future.reportResult(QJsonValue(42));
+    m_future.reportFinished();
+    m_dispatcher->invoke(call(QStringLiteral("future"), 1), collectMessage());
+
+    // watcher reports finished one through the event loop
+    QVERIFY(m_responses.isEmpty());
+    QTRY_COMPARE(m_responses.size(), 1);
+    QCOMPARE(m_responses.first().value(QStringLiteral("id")).toInt(), 1);
+    QCOMPARE(m_responses.first().value(QStringLiteral("result")).toInt(), 42);
+}
+
+void PromiseTest::futureFinishedLater()
+{
+    m_dispatcher->invoke(call(QStringLiteral("future"), 1), collectMessage());
+    QCoreApplication::processEvents();
+    QVERIFY(m_responses.isEmpty());
+
+    m_future.reportResult(QJsonValue(QStringLiteral("r")));
+    m_future.reportFinished();
+    QTRY_COMPARE(m_responses.size(), 1);
+    QCOMPARE(m_responses.first().value(QStringLiteral("result")).toString(), QStringLiteral("r"));
+}
+
+void PromiseTest::futureCanceled()
+{
+    m_dispatcher->invoke(call(QStringLiteral("future"), 1), collectMessage());
+    m_future.reportCanceled();
+    m_future.reportFinished();
+
+    QTRY_COMPARE(m_responses.size(), 1);
+    QCOMPARE(errorOf(m_responses.first()), cancelled);
+}
+
+void PromiseTest::futureException()
+{
+    m_dispatcher->invoke(call(QStringLiteral("future"), 1), collectMessage());
+    m_future.reportException(QException());
+    m_future.reportFinished();
+
+    // NOTE: failed future reads as canceled too, exception tells it apart
+    QTRY_COMPARE(m_responses.size(), 1);
+    QCOMPARE(m_responses.first().value(QStringLiteral("id")).toInt(), 1);
+    QCOMPARE(errorOf(m_responses.first()), internal);
+}
+
+QTEST_GUILESS_MAIN(PromiseTest)
+
+#include "tst_promise.moc"
@@ -0,0 +1,227 @@
+#include <qjsonrpc/qjson-rpc-frame.hpp>
+#include <qjsonrpc/qjson-rpc-shm.hpp>
+
+#include <QtTest>
+
+#include <atomic>
+
+#include <sys/mman.h>
+
+using namespace rpc::qjson;
+
+
+namespace {
+
+// smallest ring, any capacity below is rounded up to it
+constexpr int const capacity = 4096;
+
+[[nodiscard]] QByteArray pattern(int size, int seed)
+{
+    QByteArray result(size, Qt::Uninitialized);
+    for (int i = 0; i < size; ++i)
+        result[ i ] = static_cast<char>((i * 31 + seed) & 0xff);
+    return result;
+}
+
+} // namespace
+
+
+class ShmChannelTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void wraparound();
+    void peekFrameInPlace();
+    void peekFrameAcrossEnd();
+    void peekFrameHeaderAcrossEnd();
+    void peekFramePartial();
+    void pendingWrite();
+    void corruptPositions();
+
+private:
+    // moves both positions of creator -> peer ring to offset
+    void skipTo(int offset);
+
+    ShmChannel *m_creator = nullptr;
+    ShmChannel *m_peer = nullptr;
+};
+
+
+void ShmChannelTest::init()
+{
+    m_creator = new ShmChannel(this);
+    m_peer = new ShmChannel(this);
+    QCOMPARE(m_creator->create(1), 0);
+    QCOMPARE(m_peer->attach(m_creator->handles()), 0);
+}
+
+void ShmChannelTest::cleanup()
+{
+    delete m_peer;
+    m_peer = nullptr;
+    delete m_creator;
+    m_creator = nullptr;
+}
+
+void ShmChannelTest::skipTo(int offset)
+{
+    QByteArray buffer(offset, Qt::Uninitialized);
+    QCOMPARE(m_creator->write(pattern(offset, 0)), qint64(offset));
+    QCOMPARE(m_peer->read(buffer.data(), offset), qint64(offset));
+    QCOMPARE(m_peer->bytesAvailable(), qint64(0));
+}
+
+void ShmChannelTest::wraparound()
+{
+    // several laps with a size coprime to capacity, so every chunk lands at a new offset
+    int const chunk = 3001;
+    for (int i = 0; i < 8; ++i) {
+        QByteArray const data = pattern(chunk, i);
+        QCOMPARE(m_creator->write(data), qint64(chunk));
+        QCOMPARE(m_creator->bytesToWrite(), qint64(0));
+        QCOMPARE(m_peer->bytesAvailable(), qint64(chunk));
+
+        QByteArray received(chunk, Qt::Uninitialized);
+        QCOMPARE(m_peer->read(received.data(), chunk), qint64(chunk));
+        QCOMPARE(received, data);
+    }
+
+    // other direction is independent
+    QByteArray const reply = pattern(capacity, 42);
+    QCOMPARE(m_peer->write(reply), qint64(capacity));
+    QCOMPARE(m_creator->readAll(), reply);
+}
+
+void ShmChannelTest::peekFrameInPlace()
+{
+    FrameCodec codec;
+    QByteArray const message = pattern(100, 1);
+    m_creator->write(codec.encode(message));
+
+    QByteArray payload;
+    quint8 flags = 0xff;
+    QVERIFY(m_peer->peekFrame(payload, &flags));
+    QCOMPARE(payload, message);
+    QCOMPARE(flags, quint8(0));
+
+    // stays until released
+    QVERIFY(m_peer->peekFrame(payload));
+    QCOMPARE(payload, message);
+    m_peer->releaseFrame();
+    QCOMPARE(m_peer->bytesAvailable(), qint64(0));
+    QVERIFY(!m_peer->peekFrame(payload));
+}
+
+void ShmChannelTest::peekFrameAcrossEnd()
+{
+    skipTo(capacity - 50);
+
+    FrameCodec codec;
+    QByteArray const first = pattern(1000, 2);
+    QByteArray const second = pattern(10, 3);
+    m_creator->write(codec.encode(first) + codec.encode(second));
+
+    QByteArray payload;
+    QVERIFY(m_peer->peekFrame(payload));
+    QCOMPARE(payload, first);
+    m_peer->releaseFrame();
+
+    QVERIFY(m_peer->peekFrame(payload));
+    QCOMPARE(payload, second);
+    m_peer->releaseFrame();
+    QCOMPARE(m_peer->bytesAvailable(), qint64(0));
+}
+
+void ShmChannelTest::peekFrameHeaderAcrossEnd()
+{
+    FrameCodec codec;
+    QByteArray const message = pattern(300, 4);
+    QByteArray payload;
+
+    // every split of the length prefix and flags byte
+    for (int split = 1; split < frame_header_size; ++split) {
+        cleanup();
+        init();
+        skipTo(capacity - split);
+
+        m_creator->write(codec.encode(message));
+        QVERIFY(m_peer->peekFrame(payload));
+        QCOMPARE(payload, message);
+        m_peer->releaseFrame();
+        QCOMPARE(m_peer->bytesAvailable(), qint64(0));
+    }
+}
+
+void ShmChannelTest::peekFramePartial()
+{
+    skipTo(capacity - 20);
+
+    FrameCodec codec;
+    QByteArray const message = pattern(200, 5);
+    QByteArray const frame = codec.encode(message);
+    QByteArray payload;
+
+    m_creator->write(frame.left(3));
+    QVERIFY(!m_peer->peekFrame(payload));
+    m_creator->write(frame.mid(3, 100));
+    QVERIFY(!m_peer->peekFrame(payload));
+    m_creator->write(frame.mid(103));
+    QVERIFY(m_peer->peekFrame(payload));
+    QCOMPARE(payload, message);
+    m_peer->releaseFrame();
+
+    // stream reads work after released frame
+    QByteArray const tail = pattern(64, 6);
+    m_creator->write(tail);
+    QCOMPARE(m_peer->readAll(), tail);
+}
+
+void ShmChannelTest::pendingWrite()
+{
+    // more than ring holds, the rest goes once the reader makes room
+    QByteArray const data = pattern(capacity + capacity / 2, 7);
+    QCOMPARE(m_creator->write(data), qint64(data.size()));
+    QCOMPARE(m_creator->bytesToWrite(), qint64(capacity / 2));
+
+    QSignalSpy written(m_creator, &QIODevice::bytesWritten);
+    QByteArray received = m_peer->readAll();
+    QCOMPARE(received.size(), capacity);
+
+    QTRY_COMPARE(m_creator->bytesToWrite(), qint64(0));
+    QCOMPARE(written.count(), 1);
+    QCOMPARE(written.first().first().toLongLong(), qint64(capacity / 2));
+
+    received += m_peer->readAll();
+    QCOMPARE(received, data);
+}
+
+void ShmChannelTest::corruptPositions()
+{
+    ShmHandles const handles = m_creator->handles();
+    size_t const size = sizeof(std::atomic<quint64>);
+    void *const map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, handles.memory, 0);
+    QVERIFY(map != MAP_FAILED);
+
+    // head of creator -> peer ring leads the first header, see ShmChannel::RingHeader
+    static_cast<std::atomic<quint64> *>(map)->store(quint64(capacity) + 1);
+    munmap(map, size);
+
+    char byte;
+    QCOMPARE(m_peer->read(&byte, 1), qint64(-1));
+    QCOMPARE(m_peer->error(), errorCode(SystemError::SharedMemoryUnavailable));
+    QByteArray payload;
+    QVERIFY(!m_peer->peekFrame(payload));
+    QTRY_VERIFY(!m_peer->isOpen());
+
+    // creator is not affected by what it has not read
+    QVERIFY(m_creator->isOpen());
+    QCOMPARE(m_creator->error(), 0);
+}
+
+QTEST_GUILESS_MAIN(ShmChannelTest)
+
+#include "tst_shm.moc"
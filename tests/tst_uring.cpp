@@ -0,0 +1,140 @@
+#include <qjsonrpc/qjson-rpc-frame.hpp>
+#include <qjsonrpc/qjson-rpc-uring.hpp>
+
+#include <QTcpSocket>
+#include <QtTest>
+
+using namespace rpc::qjson;
+
+
+namespace {
+
+// decodes whatever has arrived, returns true once count messages are collected
+[[nodiscard]] bool readMessages(QTcpSocket &socket, FrameCodec &codec, QList<QByteArray> &messages, int count)
+{
+    codec.append(socket.readAll());
+    QByteArray message;
+    while (codec.decode(message) == 0 && !message.isNull())
+        messages.append(message);
+    return messages.size() >= count;
+}
+
+} // namespace
+
+
+class UringServerTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+
+    void loopback();
+    void splitAndCoalesced();
+    void disconnect();
+};
+
+
+void UringServerTest::init()
+{
+    if (!UringServer::isAvailable())
+        QSKIP("io_uring backend is not built or not supported by the kernel");
+}
+
+void UringServerTest::loopback()
+{
+    UringServer server;
+    QCOMPARE(server.listen(QStringLiteral("127.0.0.1"), 0), 0);
+    QVERIFY(server.isListening());
+    QVERIFY(server.port() != 0);
+
+    QSignalSpy connected(&server, &UringServer::connected);
+    QSignalSpy received(&server, &UringServer::messageReceived);
+
+    QTcpSocket client;
+    client.connectToHost(QStringLiteral("127.0.0.1"), server.port());
+    QVERIFY(client.waitForConnected(5000));
+    QTRY_COMPARE(connected.count(), 1);
+    QCOMPARE(server.connectionCount(), 1);
+    auto const connection = connected.first().first().value<quint64>();
+
+    FrameCodec codec;
+    QByteArray const request = QByteArrayLiteral(R"({"jsonrpc":"2.0","method":"ping","id":1})");
+    client.write(codec.encode(request));
+
+    QTRY_COMPARE(received.count(), 1);
+    QCOMPARE(received.first().at(0).value<quint64>(), connection);
+    QCOMPARE(received.first().at(1).toByteArray(), request);
+
+    QByteArray const response = QByteArrayLiteral(R"({"jsonrpc":"2.0","result":"pong","id":1})");
+    server.send(connection, response);
+
+    QList<QByteArray> replies;
+    QTRY_VERIFY(readMessages(client, codec, replies, 1));
+    QCOMPARE(replies, QList<QByteArray>{ response });
+}
+
+void UringServerTest::splitAndCoalesced()
+{
+    UringServer server;
+    // small provided buffers, so a message spans several receives
+    server.setBuffers(16, 256);
+    QCOMPARE(server.listen(QStringLiteral("127.0.0.1"), 0), 0);
+
+    QSignalSpy connected(&server, &UringServer::connected);
+    QSignalSpy received(&server, &UringServer::messageReceived);
+
+    QTcpSocket client;
+    client.connectToHost(QStringLiteral("127.0.0.1"), server.port());
+    QVERIFY(client.waitForConnected(5000));
+    QTRY_COMPARE(connected.count(), 1);
+    auto const connection = connected.first().first().value<quint64>();
+
+    FrameCodec codec;
+    QByteArray const large(10000, 'x');
+    QByteArray const frame = codec.encode(large);
+    client.write(frame.left(3));
+    QVERIFY(client.waitForBytesWritten(5000));
+    client.write(frame.mid(3) + codec.encode(QByteArrayLiteral("a")) + codec.encode(QByteArrayLiteral("b")));
+
+    QTRY_COMPARE(received.count(), 3);
+    QCOMPARE(received.at(0).at(1).toByteArray(), large);
+    QCOMPARE(received.at(1).at(1).toByteArray(), QByteArrayLiteral("a"));
+    QCOMPARE(received.at(2).at(1).toByteArray(), QByteArrayLiteral("b"));
+
+    // sent within one event loop pass, arrive in order
+    for (int i = 0; i < 100; ++i)
+        server.send(connection, QByteArray::number(i));
+
+    QList<QByteArray> replies;
+    QTRY_VERIFY(readMessages(client, codec, replies, 100));
+    QCOMPARE(replies.size(), 100);
+    for (int i = 0; i < 100; ++i)
+        QCOMPARE(replies.at(i), QByteArray::number(i));
+}
+
+void UringServerTest::disconnect()
+{
+    UringServer server;
+    QCOMPARE(server.listen(QStringLiteral("127.0.0.1"), 0), 0);
+
+    QSignalSpy connected(&server, &UringServer::connected);
+    QSignalSpy disconnected(&server, &UringServer::disconnected);
+
+    QTcpSocket client;
+    client.connectToHost(QStringLiteral("127.0.0.1"), server.port());
+    QVERIFY(client.waitForConnected(5000));
+    QTRY_COMPARE(connected.count(), 1);
+
+    client.disconnectFromHost();
+    QTRY_COMPARE(disconnected.count(), 1);
+    QCOMPARE(disconnected.first().first(), connected.first().first());
+    QCOMPARE(server.connectionCount(), 0);
+
+    server.close();
+    QVERIFY(!server.isListening());
+}
+
+QTEST_GUILESS_MAIN(UringServerTest)
+
+#include "tst_uring.moc"